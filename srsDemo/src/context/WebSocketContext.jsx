@@ -1,4 +1,4 @@
-import React, { createContext, useContext, useEffect, useState } from "react";
+import React, { createContext, useContext, useEffect, useRef, useState } from "react";
 import { w3cwebsocket as W3CWebSocket } from "websocket";
 
 const WebSocketContext = createContext();
@@ -8,6 +8,10 @@ export const WebSocketProvider = ({ children }) => {
     const [user, setUser] = useState(null);
     const [fileList, setFileList] = useState([]);
     const [svgData, setSvgData] = useState(null);
+    const [searchResults, setSearchResults] = useState([]);
+    const pendingRequests = useRef(new Map());
+    const nextReqId = useRef(1);
+    const latestReqIds = useRef({});
     const isLoggedIn = () => !!localStorage.getItem("sessionId");
 
     useEffect(() => {
@@ -18,6 +22,18 @@ export const WebSocketProvider = ({ children }) => {
             try {
                 const payload = JSON.parse(event.data);
 
+                // Responses can arrive out of order, so requests are matched by the reqId the server echoes back
+                const pending = pendingRequests.current.get(payload.reqId);
+                if (pending) {
+                    pendingRequests.current.delete(payload.reqId);
+                    pending.resolve(payload);
+
+                    // A newer request of the same kind owns the shared state, don't let this one overwrite it
+                    if (latestReqIds.current[pending.action] !== payload.reqId) {
+                        return;
+                    }
+                }
+
                 if (payload.error) {
                     alert(payload.error);
                     return;
@@ -41,6 +57,10 @@ export const WebSocketProvider = ({ children }) => {
                         setFileList(payload.fileList);
                         break;
 
+                    case "searchResults":
+                        setSearchResults(payload.fileList);
+                        break;
+
                     case "svgData":
                         setSvgData(payload.svgData);
                         break;
@@ -54,21 +74,31 @@ export const WebSocketProvider = ({ children }) => {
         };
 
         socket.onopen = () => console.log("WebSocket connection established.");
-        socket.onclose = () => console.log("WebSocket connection closed.");
+        socket.onclose = () => {
+            console.log("WebSocket connection closed.");
+            pendingRequests.current.forEach(({ resolve }) => resolve({ error: "WebSocket connection closed." }));
+            pendingRequests.current.clear();
+        };
 
         return () => socket.close();
     }, []);
 
+    // Resolves with the matching response payload; errors resolve too, with payload.error set
     const sendPayload = (payload) => {
         if (client?.readyState === client.OPEN) {
-            client.send(JSON.stringify(payload));
+            const reqId = nextReqId.current++;
+            latestReqIds.current[payload.action] = reqId;
+            const response = new Promise((resolve) => pendingRequests.current.set(reqId, { resolve, action: payload.action }));
+            client.send(JSON.stringify({ ...payload, reqId }));
+            return response;
         } else {
             console.error("WebSocket is not open.");
+            return Promise.resolve({ error: "WebSocket is not open." });
         }
     };
 
     const login = (username, password) => {
-        sendPayload({ action: "login", username, password });
+        return sendPayload({ action: "login", username, password });
     };
 
     const logout = () => {
@@ -78,19 +108,23 @@ export const WebSocketProvider = ({ children }) => {
     };
 
     const register = (username, password) => {
-        sendPayload({ action: "createUser", username, password });
+        return sendPayload({ action: "createUser", username, password });
     };
 
     const requestFileList = () => {
-        sendPayload({ action: "getFileList", sessionId: localStorage.getItem("sessionId") });
+        return sendPayload({ action: "getFileList", sessionId: localStorage.getItem("sessionId") });
     };
 
     const requestSvgByFileName = (fileName) => {
-        sendPayload({ action: "getFileByName", fileName, sessionId: localStorage.getItem("sessionId") });
+        return sendPayload({ action: "getFileByName", fileName, sessionId: localStorage.getItem("sessionId") });
+    };
+
+    const searchFiles = (query, limit = 20) => {
+        return sendPayload({ action: "searchFiles", query, limit, sessionId: localStorage.getItem("sessionId") });
     };
 
     const saveSvg = (fileName, svgString) => {
-        sendPayload({ action: "saveSVG", fileName, svgData: svgString, sessionId: localStorage.getItem("sessionId") });
+        return sendPayload({ action: "saveSVG", fileName, svgData: svgString, sessionId: localStorage.getItem("sessionId") });
     };
 
     return (
@@ -106,6 +140,8 @@ export const WebSocketProvider = ({ children }) => {
                 svgData,
                 requestFileList,
                 requestSvgByFileName,
+                searchResults,
+                searchFiles,
                 saveSvg,
             }}
         >
@@ -1,4 +1,5 @@
 #include "authDatabaseManager.h"
+#include "sqliteConnection.h"
 #include <sqlite3.h>
 #include <iostream>
 #include <sstream>
@@ -8,7 +9,8 @@
 #include <iomanip>
 #include <openssl/sha.h>
 
-AuthDatabaseManager::AuthDatabaseManager()
+AuthDatabaseManager::AuthDatabaseManager(const std::string& databasePath)
+    : databasePath(databasePath)
 {
     initializeDatabase();
 }
@@ -17,13 +19,7 @@ AuthDatabaseManager::~AuthDatabaseManager() = default;
 
 void AuthDatabaseManager::initializeDatabase()
 {
-    databasePath = "srs_database.db";
-    sqlite3* db = nullptr;
-
-    if (sqlite3_open(databasePath.c_str(), &db) != SQLITE_OK)
-    {
-        throw std::runtime_error("Error opening database: " + std::string(sqlite3_errmsg(db)));
-    }
+    sqlite3* db = openDatabase(databasePath);
 
     const char* createTableSQL = R"(
         CREATE TABLE IF NOT EXISTS users (
@@ -53,11 +49,7 @@ bool AuthDatabaseManager::createUser(const std::string& userName, const std::str
         throw std::invalid_argument("User name or password cannot be empty.");
     }
 
-    sqlite3* db = nullptr;
-    if (sqlite3_open(databasePath.c_str(), &db) != SQLITE_OK)
-    {
-        throw std::runtime_error("Error opening database: " + std::string(sqlite3_errmsg(db)));
-    }
+    sqlite3* db = openDatabase(databasePath);
 
     const char* checkUserSQL = R"(
         SELECT COUNT(*) FROM users WHERE userName = ?;
@@ -72,12 +64,15 @@ bool AuthDatabaseManager::createUser(const std::string& userName, const std::str
 
     sqlite3_bind_text(stmt, 1, userName.c_str(), -1, SQLITE_STATIC);
 
-    int userCount = 0;
-    if (sqlite3_step(stmt) == SQLITE_ROW)
+    if (sqlite3_step(stmt) != SQLITE_ROW)
     {
-        userCount = sqlite3_column_int(stmt, 0);
+        std::string error = sqlite3_errmsg(db);
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+        throw std::runtime_error("SQLite operation failed: " + error);
     }
 
+    int userCount = sqlite3_column_int(stmt, 0);
     sqlite3_finalize(stmt);
 
     if (userCount > 0)
@@ -123,11 +118,7 @@ bool AuthDatabaseManager::validateUser(const std::string& userName, const std::s
         throw std::invalid_argument("User name or password cannot be empty.");
     }
 
-    sqlite3* db = nullptr;
-    if (sqlite3_open(databasePath.c_str(), &db) != SQLITE_OK)
-    {
-        throw std::runtime_error("Error opening database: " + std::string(sqlite3_errmsg(db)));
-    }
+    sqlite3* db = openDatabase(databasePath);
 
     const char* selectSQL = R"(
         SELECT password, salt FROM users WHERE userName = ?;
@@ -143,16 +134,22 @@ bool AuthDatabaseManager::validateUser(const std::string& userName, const std::s
     sqlite3_bind_text(stmt, 1, userName.c_str(), -1, SQLITE_STATIC);
 
     std::string storedHashedPassword, storedSalt;
-    if (sqlite3_step(stmt) == SQLITE_ROW)
+    int stepResult = sqlite3_step(stmt);
+    if (stepResult == SQLITE_ROW)
     {
         storedHashedPassword = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
         storedSalt = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
     }
     else
     {
+        std::string error = sqlite3_errmsg(db);
         sqlite3_finalize(stmt);
         sqlite3_close(db);
-        return false;
+        if (stepResult == SQLITE_DONE)
+        {
+            return false;
+        }
+        throw std::runtime_error("SQLite operation failed: " + error);
     }
 
     sqlite3_finalize(stmt);
@@ -7,7 +7,7 @@
 class AuthDatabaseManager
 {
 public:
-    AuthDatabaseManager();
+    explicit AuthDatabaseManager(const std::string& databasePath);
     ~AuthDatabaseManager();
 
     bool createUser(const std::string& userName, const std::string& password);
@@ -0,0 +1,99 @@
+#include "rateLimiter.h"
+#include <algorithm>
+
+ActionClass classifyAction(const std::string& action)
+{
+    if (action == "login" || action == "createUser" || action == "logout")
+    {
+        return ActionClass::Auth;
+    }
+
+    if (action == "saveSVG")
+    {
+        return ActionClass::Write;
+    }
+
+    if (action == "exportAll" || action == "importAll")
+    {
+        return ActionClass::Bulk;
+    }
+
+    return ActionClass::Read;
+}
+
+const char* actionClassName(ActionClass actionClass)
+{
+    switch (actionClass)
+    {
+    case ActionClass::Auth: return "auth";
+    case ActionClass::Read: return "read";
+    case ActionClass::Write: return "write";
+    case ActionClass::Bulk: return "bulk";
+    }
+    return "unknown";
+}
+
+void TokenBucket::refill(const RateLimit& limit, Clock::time_point now)
+{
+    double capacity = std::max(limit.burst, 1.0);
+    if (tokens < 0)
+    {
+        tokens = capacity;
+    }
+    else
+    {
+        double elapsed = std::chrono::duration<double>(now - lastRefill).count();
+        tokens = std::min(capacity, tokens + elapsed * limit.ratePerSecond);
+    }
+    lastRefill = now;
+}
+
+bool TokenBucket::tryTake(const RateLimit& limit, Clock::time_point now)
+{
+    if (!hasToken(limit, now))
+    {
+        return false;
+    }
+
+    if (limit.ratePerSecond > 0)
+    {
+        tokens -= 1;
+    }
+    return true;
+}
+
+bool TokenBucket::hasToken(const RateLimit& limit, Clock::time_point now)
+{
+    if (limit.ratePerSecond <= 0)
+    {
+        return true;
+    }
+
+    refill(limit, now);
+    return tokens >= 1;
+}
+
+KeyedTokenBuckets::KeyedTokenBuckets(size_t maxKeys)
+    : maxKeys(maxKeys)
+{
+}
+
+TokenBucket& KeyedTokenBuckets::get(const std::string& key, ActionClass actionClass)
+{
+    auto it = entries.find(key);
+    if (it != entries.end())
+    {
+        recency.splice(recency.begin(), recency, it->second.recency);
+        return it->second.buckets[static_cast<size_t>(actionClass)];
+    }
+
+    if (entries.size() >= maxKeys && !recency.empty())
+    {
+        entries.erase(recency.back());
+        recency.pop_back();
+    }
+
+    recency.push_front(key);
+    it = entries.emplace(key, Entry{ {}, recency.begin() }).first;
+    return it->second.buckets[static_cast<size_t>(actionClass)];
+}
@@ -0,0 +1,70 @@
+#ifndef RATELIMITER_H
+#define RATELIMITER_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+//Requests are limited per class rather than per action, so e.g. login and createUser share one budget
+enum class ActionClass
+{
+    Auth,
+    Read,
+    Write,
+    Bulk
+};
+
+constexpr size_t actionClassCount = 4;
+
+ActionClass classifyAction(const std::string& action);
+const char* actionClassName(ActionClass actionClass);
+
+struct RateLimit
+{
+    double ratePerSecond = 0; //0 disables the limit
+    double burst = 0;
+};
+
+class TokenBucket
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    //Starts full, so a new connection or user gets the whole burst
+    bool tryTake(const RateLimit& limit, Clock::time_point now);
+
+    //Same check as tryTake without spending a token, for limits charged only once the outcome is known
+    bool hasToken(const RateLimit& limit, Clock::time_point now);
+
+private:
+    double tokens = -1;
+    Clock::time_point lastRefill;
+
+    void refill(const RateLimit& limit, Clock::time_point now);
+};
+
+//One bucket per action class for each key, e.g. a user name. Holds at most maxKeys keys and evicts
+//the least recently used one when full, so keys taken from client input cannot grow it without bound.
+class KeyedTokenBuckets
+{
+public:
+    explicit KeyedTokenBuckets(size_t maxKeys);
+
+    TokenBucket& get(const std::string& key, ActionClass actionClass);
+
+private:
+    struct Entry
+    {
+        std::array<TokenBucket, actionClassCount> buckets;
+        std::list<std::string>::iterator recency;
+    };
+
+    size_t maxKeys;
+    std::unordered_map<std::string, Entry> entries;
+    std::list<std::string> recency; //most recently used first
+};
+
+#endif // RATELIMITER_H
@@ -0,0 +1,101 @@
+#include "serverConfig.h"
+#include <nlohmann/json.hpp>
+#include <fstream>
+#include <stdexcept>
+
+using json = nlohmann::json;
+
+namespace
+{
+    void readRateLimit(const json& section, const char* key, RateLimit& limit)
+    {
+        if (!section.contains(key))
+        {
+            return;
+        }
+
+        const json& value = section.at(key);
+        limit.ratePerSecond = value.value("rate", limit.ratePerSecond);
+        limit.burst = value.value("burst", limit.burst);
+
+        if (limit.ratePerSecond < 0 || limit.burst < 0)
+        {
+            throw std::invalid_argument(std::string("Rate limits cannot be negative: ") + key);
+        }
+    }
+}
+
+ServerConfig ServerConfig::load(const std::string& configPath)
+{
+    ServerConfig config;
+
+    std::ifstream file(configPath);
+    if (!file.is_open())
+    {
+        return config;
+    }
+
+    json root;
+    try
+    {
+        root = json::parse(file);
+    }
+    catch (const json::exception& e)
+    {
+        throw std::runtime_error("Error parsing " + configPath + ": " + e.what());
+    }
+
+    try
+    {
+        config.port = root.value("port", config.port);
+        config.databasePath = root.value("databasePath", config.databasePath);
+        config.maxPayloadLength = root.value("maxPayloadLength", config.maxPayloadLength);
+        config.maxBackpressure = root.value("maxBackpressure", config.maxBackpressure);
+        config.idleTimeout = root.value("idleTimeout", config.idleTimeout);
+        config.workerThreads = root.value("workerThreads", config.workerThreads);
+        config.maxInFlightPerConnection = root.value("maxInFlightPerConnection", config.maxInFlightPerConnection);
+        config.maxConcurrentRequests = root.value("maxConcurrentRequests", config.maxConcurrentRequests);
+
+        if (root.contains("rateLimits"))
+        {
+            const json& rateLimits = root.at("rateLimits");
+            for (size_t i = 0; i < actionClassCount; ++i)
+            {
+                const char* className = actionClassName(static_cast<ActionClass>(i));
+                if (rateLimits.contains(className))
+                {
+                    readRateLimit(rateLimits.at(className), "perConnection", config.rateLimits[i].perConnection);
+                    readRateLimit(rateLimits.at(className), "perUser", config.rateLimits[i].perUser);
+                }
+            }
+        }
+    }
+    catch (const json::exception& e)
+    {
+        throw std::runtime_error("Invalid value in " + configPath + ": " + e.what());
+    }
+
+    if (config.port <= 0 || config.port > 65535)
+    {
+        throw std::invalid_argument("Port must be between 1 and 65535.");
+    }
+
+    //uWebSockets refuses idle timeouts between 1 and 7 seconds
+    if (config.idleTimeout != 0 && config.idleTimeout < 8)
+    {
+        throw std::invalid_argument("idleTimeout must be 0 or at least 8 seconds.");
+    }
+
+    //Exports pause once the send buffer reaches a quarter of this, a smaller limit stalls them after nearly every chunk
+    if (config.maxBackpressure < 1024 * 1024)
+    {
+        throw std::invalid_argument("maxBackpressure must be at least 1 MiB.");
+    }
+
+    if (config.databasePath.empty() || config.maxPayloadLength == 0 || config.maxInFlightPerConnection == 0 || config.maxConcurrentRequests == 0)
+    {
+        throw std::invalid_argument("databasePath, maxPayloadLength and the request limits must be set.");
+    }
+
+    return config;
+}
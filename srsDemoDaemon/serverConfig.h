@@ -0,0 +1,43 @@
+#ifndef SERVERCONFIG_H
+#define SERVERCONFIG_H
+
+#include "rateLimiter.h"
+#include <array>
+#include <string>
+
+struct ActionLimits
+{
+    RateLimit perConnection;
+    RateLimit perUser; //for auth, failed logins per account and client address
+};
+
+//Runtime settings, read from a JSON file so a deployment can be tuned without rebuilding.
+//Every key is optional and falls back to the defaults below.
+struct ServerConfig
+{
+    int port = 8080;
+    std::string databasePath = "srs_database.db";
+
+    unsigned int maxPayloadLength = 16 * 1024 * 1024;
+    unsigned int maxBackpressure = 16 * 1024 * 1024;
+    unsigned short idleTimeout = 120;
+
+    unsigned int workerThreads = 0; //0 uses one per hardware thread
+    unsigned int maxInFlightPerConnection = 32;
+    unsigned int maxConcurrentRequests = 256;
+
+    //Indexed by ActionClass
+    std::array<ActionLimits, actionClassCount> rateLimits = { {
+        { { 5, 10 }, { 1, 5 } },         //auth, per user limits password guessing
+        { { 100, 200 }, { 200, 400 } },  //read
+        { { 20, 40 }, { 40, 80 } },      //write
+        { { 0.1, 2 }, { 0.1, 2 } }       //bulk
+    } };
+
+    const ActionLimits& limitsFor(ActionClass actionClass) const { return rateLimits[static_cast<size_t>(actionClass)]; }
+
+    //Missing file yields the defaults, a malformed one throws
+    static ServerConfig load(const std::string& configPath);
+};
+
+#endif // SERVERCONFIG_H
@@ -0,0 +1,22 @@
+#include "sqliteConnection.h"
+#include <sqlite3.h>
+#include <stdexcept>
+
+namespace
+{
+    constexpr int busyTimeoutMs = 5000;
+}
+
+sqlite3* openDatabase(const std::string& databasePath)
+{
+    sqlite3* db = nullptr;
+    if (sqlite3_open(databasePath.c_str(), &db) != SQLITE_OK)
+    {
+        std::string error = sqlite3_errmsg(db);
+        sqlite3_close(db);
+        throw std::runtime_error("Error opening database: " + error);
+    }
+
+    sqlite3_busy_timeout(db, busyTimeoutMs);
+    return db;
+}
@@ -0,0 +1,13 @@
+#ifndef SQLITECONNECTION_H
+#define SQLITECONNECTION_H
+
+#include <string>
+
+struct sqlite3;
+
+//Shared by both database managers. Reads run on worker threads while writes run on the event loop,
+//each on its own connection, so every connection waits out a competing writer instead of failing with SQLITE_BUSY.
+//Throws std::runtime_error if the database cannot be opened.
+sqlite3* openDatabase(const std::string& databasePath);
+
+#endif // SQLITECONNECTION_H
@@ -1,8 +1,18 @@
 #include "SVGDatabaseManager.h"
 #include "AuthDatabaseManager.h"
+#include "serverConfig.h"
+#include "svgArchive.h"
+#include "trafficTrace.h"
+#include "workerPool.h"
 #include <uwebsockets/App.h>
 #include <nlohmann/json.hpp>
 #include <tinyxml2.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <iostream>
 #include <stdexcept>
 #include <string>
@@ -11,11 +21,58 @@
 #include <unordered_map>
 #include <mutex>
 #include <random>
+#include <utility>
 
 using json = nlohmann::json;
 
-//Purposefully empty
-struct PerConnectionData{};
+constexpr size_t exportPageSize = 64;
+constexpr size_t exportChunkBytes = 256 * 1024;
+constexpr size_t importBatchSize = 1000;
+constexpr size_t cliReadChunkBytes = 1024 * 1024;
+constexpr int defaultSearchLimit = 20;
+constexpr int maxSearchLimit = 100;
+constexpr size_t maxTrackedUsers = 10000;
+
+//Loaded in main from --config, or srsDemoDaemon.json in the working directory
+ServerConfig serverConfig;
+
+struct PerConnectionData
+{
+    uint64_t connectionID = 0;
+    unsigned int inFlight = 0;
+    std::array<TokenBucket, actionClassCount> rateBuckets;
+
+    //Bulk export cursor, resumed from the drain handler whenever the send buffer empties
+    bool exportActive = false;
+    json exportReqId;
+    std::string exportUser;
+    std::string exportCursor;
+    size_t exportCount = 0;
+    bool exportSent = false; //end marker queued, the reply waits until the buffer is back under the limit
+
+    //Bulk import state, fed by binary messages after an importAll request
+    bool importActive = false;
+    json importReqId;
+    std::string importUser;
+    SVGArchiveReader importReader;
+    std::vector<std::pair<std::string, std::vector<unsigned char>>> importBatch;
+    size_t importCount = 0;
+};
+
+using ServerWebSocket = uWS::WebSocket<false, true, PerConnectionData>;
+
+//Only touched on the event loop thread. Worker results look their socket up here, since it may have closed meanwhile.
+std::unordered_map<uint64_t, ServerWebSocket*> openConnections;
+uint64_t nextConnectionID = 1;
+
+//Requests queued or running on the worker pool across all connections, also event loop only
+unsigned int activeRequests = 0;
+
+//Per user and per login source buckets, event loop only
+KeyedTokenBuckets userRateBuckets(maxTrackedUsers);
+
+//Set by --capture, records every incoming frame for later replay
+std::unique_ptr<TrafficCapture> trafficCapture;
 
 std::string getCurrentTimestamp()
 {
@@ -27,6 +84,9 @@ std::string getCurrentTimestamp()
 
 void logMessage(const std::string& message, bool isError = false)
 {
+    static std::mutex logMutex;
+    std::lock_guard<std::mutex> lock(logMutex);
+
     static std::ofstream logFile("logfile.txt", std::ios::app);
 
     if (!logFile.is_open())
@@ -96,7 +156,7 @@ void removeSession(const std::string& sessionID)
     sessionStore.erase(sessionID);
 }
 
-void handleLogin(AuthDatabaseManager& authDbManager, const json& payload, auto* ws)
+json handleLogin(AuthDatabaseManager& authDbManager, const json& payload)
 {
     std::string username = payload["username"].is_null() ? "" : payload.value("username", "");
     std::string password = payload["password"].is_null() ? "" : payload.value("password", "");
@@ -105,42 +165,36 @@ void handleLogin(AuthDatabaseManager& authDbManager, const json& payload, auto*
     {
         std::string sessionID = generateSessionID();
         addSession(sessionID, username);
-        json response = {
+        logMessage("User " + username + " logged in successfully.");
+        return {
             {"action", "login"},
             {"sessionId", sessionID},
             {"username", username},
             {"message", "Login successful"}
         };
-        ws->send(response.dump(), uWS::OpCode::TEXT);
-        logMessage("User " + username + " logged in successfully.");
-    }
-    else
-    {
-        ws->send(R"({"action": "login", "error": "Invalid credentials"})", uWS::OpCode::TEXT);
-        logMessage("Failed login attempt for user " + username, true);
     }
+
+    logMessage("Failed login attempt for user " + username, true);
+    return { {"action", "login"}, {"error", "Invalid credentials"} };
 }
 
-void handleLogout(const json& payload, auto* ws)
+json handleLogout(const json& payload)
 {
     std::string sessionID = payload["sessionId"].is_null() ? "" : payload.value("sessionId", "");
 
     if (!sessionID.empty())
     {
         removeSession(sessionID);
-        json response = { {"action", "logout"}, {"message", "Logout successful"} };
-        ws->send(response.dump(), uWS::OpCode::TEXT);
         logMessage("Session " + sessionID + " logged out.");
+        return { {"action", "logout"}, {"message", "Logout successful"} };
     }
-    else
-    {
-        ws->send(R"({"action": "logout", "error": "Invalid session"})", uWS::OpCode::TEXT);
-        logMessage("Logout attempt failed due to missing session ID.", true);
-    }
+
+    logMessage("Logout attempt failed due to missing session ID.", true);
+    return { {"action", "logout"}, {"error", "Invalid session"} };
 }
 
 
-void handleCreateUser(AuthDatabaseManager& authDbManager, const json& payload, auto* ws)
+json handleCreateUser(AuthDatabaseManager& authDbManager, const json& payload)
 {
     std::string username = payload["username"].is_null() ? "" : payload.value("username", "");
     std::string password = payload["password"].is_null() ? "" : payload.value("password", "");
@@ -149,23 +203,20 @@ void handleCreateUser(AuthDatabaseManager& authDbManager, const json& payload, a
     {
         std::string sessionID = generateSessionID();
         addSession(sessionID, username);
-        json response = {
+        logMessage("User " + username + " created successfully.");
+        return {
             {"action", "createUser"},
             {"sessionId", sessionID},
             {"username", username},
             {"message", "Registration successful."}
         };
-        ws->send(response.dump(), uWS::OpCode::TEXT);
-        logMessage("User " + username + " created successfully.");
-    }
-    else
-    {
-        ws->send(R"({"action": "createUser", "error": "User already exists."})", uWS::OpCode::TEXT);
-        logMessage("Failed registration attempt for user " + username, true);
     }
+
+    logMessage("Failed registration attempt for user " + username, true);
+    return { {"action", "createUser"}, {"error", "User already exists."} };
 }
 
-void handleGetFileList(SVGDatabaseManager& dbManager, const json& payload, auto* ws)
+json handleGetFileList(SVGDatabaseManager& dbManager, const json& payload)
 {
     std::string sessionID = payload["sessionId"].is_null() ? "" : payload.value("sessionId", "");
     std::string username;
@@ -173,18 +224,15 @@ void handleGetFileList(SVGDatabaseManager& dbManager, const json& payload, auto*
     if (validateSession(sessionID, username))
     {
         std::vector<std::string> fileList = dbManager.getFileList(username);
-        json response = { {"action", "fileList"}, {"fileList", fileList} };
-        ws->send(response.dump(), uWS::OpCode::TEXT);
         logMessage("File list sent to user " + username);
+        return { {"action", "fileList"}, {"fileList", fileList} };
     }
-    else
-    {
-        ws->send(R"({"action": "fileList", "error": "Unauthorized"})", uWS::OpCode::TEXT);
-        logMessage("Unauthorized attempt to access file list.", true);
-    }
+
+    logMessage("Unauthorized attempt to access file list.", true);
+    return { {"action", "fileList"}, {"error", "Unauthorized"} };
 }
 
-void handleGetSVG(SVGDatabaseManager& dbManager, const json& payload, auto* ws)
+json handleGetSVG(SVGDatabaseManager& dbManager, const json& payload)
 {
     std::string sessionID = payload["sessionId"].is_null() ? "" : payload.value("sessionId", "");
     std::string username;
@@ -197,24 +245,19 @@ void handleGetSVG(SVGDatabaseManager& dbManager, const json& payload, auto* ws)
         if (!svgData.empty())
         {
             std::string svgDataStr(svgData.begin(), svgData.end());
-            json response = { {"action", "svgData"}, {"svgData", svgDataStr} };
-            ws->send(response.dump(), uWS::OpCode::TEXT);
             logMessage("SVG data for " + fileName + " sent to user " + username);
+            return { {"action", "svgData"}, {"svgData", svgDataStr} };
         }
-        else
-        {
-            ws->send(R"({"action": "svgData", "error": "File not found."})", uWS::OpCode::TEXT);
-            logMessage("User " + username + " got empty result when trying to access file: " + fileName, true);
-        }
-    }
-    else
-    {
-        ws->send(R"({"action": "svgData", "error": "Unauthorized"})", uWS::OpCode::TEXT);
-        logMessage("Unauthorized attempt to retrieve SVG.", true);
+
+        logMessage("User " + username + " got empty result when trying to access file: " + fileName, true);
+        return { {"action", "svgData"}, {"error", "File not found."} };
     }
+
+    logMessage("Unauthorized attempt to retrieve SVG.", true);
+    return { {"action", "svgData"}, {"error", "Unauthorized"} };
 }
 
-void handleSaveSVG(SVGDatabaseManager& dbManager, const json& payload, auto* ws)
+json handleSaveSVG(SVGDatabaseManager& dbManager, const json& payload)
 {
     std::string sessionID = payload["sessionId"].is_null() ? "" : payload.value("sessionId", "");
     std::string username;
@@ -229,68 +272,430 @@ void handleSaveSVG(SVGDatabaseManager& dbManager, const json& payload, auto* ws)
         try
         {
             dbManager.saveSVG(fileName, username, svgDataVec);
-            ws->send(R"({"success": "SVG saved successfully"})", uWS::OpCode::TEXT);
             logMessage("SVG file '" + fileName + "' saved for user: " + username);
+            return { {"success", "SVG saved successfully"} };
         }
         catch (const std::exception& e)
         {
-            ws->send(R"({"error": "Failed to save SVG"})", uWS::OpCode::TEXT);
             logMessage("Error saving SVG for user " + username + ": " + std::string(e.what()), true);
+            return { {"error", "Failed to save SVG"} };
         }
     }
-    else
+
+    logMessage("Unauthorized attempt to save SVG.", true);
+    return { {"error", "Unauthorized"} };
+}
+
+json handleSearchFiles(SVGDatabaseManager& dbManager, const json& payload)
+{
+    std::string sessionID = payload["sessionId"].is_null() ? "" : payload.value("sessionId", "");
+    std::string username;
+
+    if (validateSession(sessionID, username))
+    {
+        std::string query = payload.value("query", "");
+        int limit = payload.contains("limit") && payload["limit"].is_number_integer() ? payload["limit"].get<int>() : defaultSearchLimit;
+        limit = std::clamp(limit, 1, maxSearchLimit);
+
+        std::vector<std::string> fileList = dbManager.searchFiles(username, query, limit);
+        logMessage("Search results for '" + query + "' sent to user " + username);
+        return { {"action", "searchResults"}, {"query", query}, {"fileList", fileList} };
+    }
+
+    logMessage("Unauthorized attempt to search files.", true);
+    return { {"action", "searchResults"}, {"error", "Unauthorized"} };
+}
+
+json requestID(const json& payload)
+{
+    return payload.contains("reqId") ? payload["reqId"] : json();
+}
+
+//Builds the reply for a request shed before parsing. The reqId is found with a raw scan and echoed only when
+//it is a whole integer or an unescaped string, so the client can still settle the request it belongs to.
+//Clients append reqId last, hence the search from the end.
+std::string busyResponse(std::string_view message)
+{
+    constexpr size_t npos = std::string_view::npos;
+    std::string_view reqId;
+
+    size_t key = message.rfind("\"reqId\"");
+    if (key != npos && (key == 0 || message[key - 1] != '\\'))
+    {
+        size_t colon = message.find_first_not_of(" \t\r\n", key + 7);
+        size_t start = colon != npos && message[colon] == ':' ? message.find_first_not_of(" \t\r\n", colon + 1) : npos;
+
+        if (start != npos && message[start] == '"')
+        {
+            size_t end = message.find_first_of("\"\\", start + 1);
+            if (end != npos && message[end] == '"')
+            {
+                reqId = message.substr(start, end + 1 - start);
+            }
+        }
+        else if (start != npos)
+        {
+            //1.5 or 1e3 must not be cut down to 1, which could settle some other pending request
+            size_t digits = start + (message[start] == '-' ? 1 : 0);
+            size_t end = std::min(message.find_first_not_of("0123456789", digits), message.size());
+            if (end > digits && end < message.size() && std::string_view(" \t\r\n,}").find(message[end]) != std::string_view::npos)
+            {
+                reqId = message.substr(start, end - start);
+            }
+        }
+    }
+
+    std::string response = R"({"error": "Server busy")";
+    if (!reqId.empty())
+    {
+        response.append(R"(, "reqId": )").append(reqId);
+    }
+    return response + "}";
+}
+
+//Echoes the client's reqId so responses can be matched regardless of the order they complete in
+void sendResponse(auto* ws, const json& reqId, json response)
+{
+    if (!reqId.is_null())
+    {
+        response["reqId"] = reqId;
+    }
+    ws->send(response.dump(), uWS::OpCode::TEXT);
+}
+
+//Only sends while the buffer is under a quarter of maxBackpressure. A chunk holds whole documents and can
+//still push the buffer past the limit, after which uWebSockets drops sends, so the closing reply is also
+//only sent from a later pass once the buffer has drained.
+void pumpExport(SVGDatabaseManager& dbManager, auto* ws)
+{
+    PerConnectionData* data = ws->getUserData();
+
+    try
     {
-        ws->send(R"({"error": "Unauthorized"})", uWS::OpCode::TEXT);
-        logMessage("Unauthorized attempt to save SVG.", true);
+        while (data->exportActive && ws->getBufferedAmount() < serverConfig.maxBackpressure / 4)
+        {
+            if (data->exportSent)
+            {
+                data->exportActive = false;
+                sendResponse(ws, data->exportReqId, { {"action", "exportAll"}, {"count", data->exportCount}, {"message", "Export complete"} });
+                logMessage("Exported " + std::to_string(data->exportCount) + " files for user " + data->exportUser);
+                break;
+            }
+
+            std::string chunk;
+            bool chunkFull = false;
+            size_t rowCount = dbManager.exportSVGs(data->exportUser, data->exportCursor, exportPageSize,
+                [&](const std::string& fileName, const unsigned char* svgData, size_t size)
+                {
+                    SVGArchiveWriter::appendRecord(chunk, fileName, svgData, size);
+                    data->exportCursor = fileName;
+                    ++data->exportCount;
+                    chunkFull = chunk.size() >= exportChunkBytes;
+                    return !chunkFull;
+                });
+
+            if (!chunkFull && rowCount < exportPageSize)
+            {
+                SVGArchiveWriter::appendEnd(chunk);
+                data->exportSent = true;
+            }
+
+            ws->send(chunk, uWS::OpCode::BINARY);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        data->exportActive = false;
+        sendResponse(ws, data->exportReqId, { {"action", "exportAll"}, {"error", "Export failed"} });
+        logMessage("Error exporting files for user " + data->exportUser + ": " + std::string(e.what()), true);
     }
 }
 
-void handleMessage(SVGDatabaseManager& dbManager, AuthDatabaseManager& authDbManager, std::string_view message, auto* ws)
+void handleExportAll(SVGDatabaseManager& dbManager, const json& payload, auto* ws)
 {
+    std::string sessionID = payload["sessionId"].is_null() ? "" : payload.value("sessionId", "");
+    std::string username;
+
+    if (!validateSession(sessionID, username))
+    {
+        sendResponse(ws, requestID(payload), { {"action", "exportAll"}, {"error", "Unauthorized"} });
+        logMessage("Unauthorized attempt to export files.", true);
+        return;
+    }
+
+    PerConnectionData* data = ws->getUserData();
+    if (data->exportActive)
+    {
+        sendResponse(ws, requestID(payload), { {"action", "exportAll"}, {"error", "Export already in progress"} });
+        return;
+    }
+
+    data->exportActive = true;
+    data->exportReqId = requestID(payload);
+    data->exportUser = username;
+    data->exportCursor.clear();
+    data->exportCount = 0;
+    data->exportSent = false;
+
+    std::string header;
+    SVGArchiveWriter::appendHeader(header);
+    ws->send(header, uWS::OpCode::BINARY);
+
+    logMessage("Starting export for user " + username);
+    pumpExport(dbManager, ws);
+}
+
+void resetImport(PerConnectionData* data)
+{
+    data->importActive = false;
+    data->importReqId = json();
+    data->importUser.clear();
+    data->importReader = SVGArchiveReader();
+    data->importBatch.clear();
+    data->importCount = 0;
+}
+
+void handleImportAll(const json& payload, auto* ws)
+{
+    std::string sessionID = payload["sessionId"].is_null() ? "" : payload.value("sessionId", "");
+    std::string username;
+
+    if (!validateSession(sessionID, username))
+    {
+        sendResponse(ws, requestID(payload), { {"action", "importAll"}, {"error", "Unauthorized"} });
+        logMessage("Unauthorized attempt to import files.", true);
+        return;
+    }
+
+    PerConnectionData* data = ws->getUserData();
+    resetImport(data);
+    data->importActive = true;
+    data->importReqId = requestID(payload);
+    data->importUser = username;
+
+    sendResponse(ws, data->importReqId, { {"action", "importAll"}, {"message", "Ready for archive data"} });
+    logMessage("Starting import for user " + username);
+}
+
+void handleBinaryMessage(SVGDatabaseManager& dbManager, std::string_view message, auto* ws)
+{
+    PerConnectionData* data = ws->getUserData();
+
+    if (!data->importActive)
+    {
+        ws->send(R"({"action": "importAll", "error": "No import in progress"})", uWS::OpCode::TEXT);
+        logMessage("Binary message received without an active import.", true);
+        return;
+    }
+
+    try
+    {
+        data->importReader.feed(message);
+
+        SVGArchiveReader::Record record;
+        while (data->importReader.next(record))
+        {
+            data->importBatch.emplace_back(std::move(record.fileName), std::move(record.svgData));
+            if (data->importBatch.size() >= importBatchSize)
+            {
+                dbManager.importSVGs(data->importUser, data->importBatch);
+                data->importCount += data->importBatch.size();
+                data->importBatch.clear();
+            }
+        }
+
+        if (data->importReader.isFinished())
+        {
+            dbManager.importSVGs(data->importUser, data->importBatch);
+            data->importCount += data->importBatch.size();
+
+            sendResponse(ws, data->importReqId, { {"action", "importAll"}, {"count", data->importCount}, {"message", "Import complete"} });
+            logMessage("Imported " + std::to_string(data->importCount) + " files for user " + data->importUser);
+            resetImport(data);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        sendResponse(ws, data->importReqId, { {"action", "importAll"}, {"error", "Import failed"} });
+        logMessage("Error importing files for user " + data->importUser + ": " + std::string(e.what()), true);
+        resetImport(data);
+    }
+}
+
+//Lets a replay map the session alias in the trace onto the session its own login receives
+void captureSessionIssued(auto* ws, const json& response)
+{
+    if (trafficCapture && response.contains("sessionId"))
+    {
+        trafficCapture->recordSessionIssued(ws->getUserData()->connectionID, response["sessionId"].get<std::string>());
+    }
+}
+
+//Failed logins are counted per account and client address, which limits guessing any one password
+//without letting someone elsewhere lock the real user out
+std::string loginSourceKey(const json& payload, auto* ws)
+{
+    std::string username = payload.contains("username") && payload["username"].is_string() ? payload["username"].get<std::string>() : "";
+    return username + '\n' + std::string(ws->getRemoteAddressAsText());
+}
+
+//Charges the connection and the user behind the request one token of the action's class.
+//A login is only checked against its source's failure budget here, handleMessage charges it if the login fails.
+bool admitRequest(const json& payload, const std::string& action, ActionClass actionClass, auto* ws)
+{
+    TokenBucket::Clock::time_point now = TokenBucket::Clock::now();
+    const ActionLimits& limits = serverConfig.limitsFor(actionClass);
+
+    if (!ws->getUserData()->rateBuckets[static_cast<size_t>(actionClass)].tryTake(limits.perConnection, now))
+    {
+        return false;
+    }
+
+    if (actionClass == ActionClass::Auth)
+    {
+        return action != "login" || userRateBuckets.get(loginSourceKey(payload, ws), actionClass).hasToken(limits.perUser, now);
+    }
+
+    std::string username;
+    if (payload.contains("sessionId") && payload["sessionId"].is_string())
+    {
+        validateSession(payload["sessionId"].get<std::string>(), username);
+    }
+
+    //Unauthenticated requests are only charged to the connection, the handler rejects them anyway
+    if (username.empty())
+    {
+        return true;
+    }
+
+    return userRateBuckets.get(username, actionClass).tryTake(limits.perUser, now);
+}
+
+void chargeFailedLogin(const json& payload, auto* ws)
+{
+    userRateBuckets.get(loginSourceKey(payload, ws), ActionClass::Auth).tryTake(serverConfig.limitsFor(ActionClass::Auth).perUser, TokenBucket::Clock::now());
+}
+
+//Runs a read on the worker pool and posts the response back to the event loop, so a slow read
+//completes out of order instead of holding up everything queued behind it on this socket
+void handleAsync(WorkerPool& workerPool, json payload, auto* ws, std::function<json(const json&)> handler)
+{
+    PerConnectionData* data = ws->getUserData();
+    ++data->inFlight;
+    ++activeRequests;
+
+    uWS::Loop* loop = uWS::Loop::get();
+    uint64_t connectionID = data->connectionID;
+
+    workerPool.submit([loop, connectionID, payload = std::move(payload), handler = std::move(handler)]()
+        {
+            json response;
+            try
+            {
+                response = handler(payload);
+            }
+            catch (const std::exception& e)
+            {
+                logMessage("Unexpected error: " + std::string(e.what()), true);
+                response = { {"error", "Internal server error"} };
+            }
+
+            loop->defer([connectionID, reqId = requestID(payload), response = std::move(response)]()
+                {
+                    --activeRequests;
+
+                    auto it = openConnections.find(connectionID);
+                    if (it == openConnections.end())
+                    {
+                        return;
+                    }
+
+                    --it->second->getUserData()->inFlight;
+                    sendResponse(it->second, reqId, response);
+                });
+        });
+}
+
+void handleMessage(SVGDatabaseManager& dbManager, AuthDatabaseManager& authDbManager, WorkerPool& workerPool, std::string_view message, auto* ws)
+{
+    json reqId;
+
     try
     {
         auto payload = json::parse(message);
+        reqId = requestID(payload);
 
         if (!payload.contains("action")) {
-            ws->send(R"({"error": "Missing 'action' field in payload"})", uWS::OpCode::TEXT);
+            sendResponse(ws, reqId, { {"error", "Missing 'action' field in payload"} });
             logMessage("Missing 'action' in payload.", true);
             return;
         }
 
         std::string action = payload["action"];
 
+        if (ws->getUserData()->inFlight >= serverConfig.maxInFlightPerConnection) {
+            sendResponse(ws, reqId, { {"action", action}, {"error", "Too many requests in flight"} });
+            logMessage("Rejected " + action + ", connection has " + std::to_string(serverConfig.maxInFlightPerConnection) + " requests in flight.", true);
+            return;
+        }
+
+        ActionClass actionClass = classifyAction(action);
+        if (!admitRequest(payload, action, actionClass, ws)) {
+            sendResponse(ws, reqId, { {"action", action}, {"error", "Rate limit exceeded"} });
+            logMessage("Rate limited " + action + " (" + actionClassName(actionClass) + ").", true);
+            return;
+        }
+
+        //Reads run on the worker pool and may answer out of order. Writes and session changes stay
+        //on the event loop, so they apply in the order the client sent them.
         if (action == "login") {
-            handleLogin(authDbManager, payload, ws);
+            json response = handleLogin(authDbManager, payload);
+            if (response.contains("error")) {
+                chargeFailedLogin(payload, ws);
+            }
+            captureSessionIssued(ws, response);
+            sendResponse(ws, reqId, response);
         }
         else if (action == "logout") {
-            handleLogout(payload, ws);
+            sendResponse(ws, reqId, handleLogout(payload));
         }
         else if (action == "createUser") {
-            handleCreateUser(authDbManager, payload, ws);
+            json response = handleCreateUser(authDbManager, payload);
+            captureSessionIssued(ws, response);
+            sendResponse(ws, reqId, response);
         }
         else if (action == "getFileList") {
-            handleGetFileList(dbManager, payload, ws);
+            handleAsync(workerPool, std::move(payload), ws, [&dbManager](const json& request) { return handleGetFileList(dbManager, request); });
         }
         else if (action == "getFileByName") {
-            handleGetSVG(dbManager, payload, ws);
+            handleAsync(workerPool, std::move(payload), ws, [&dbManager](const json& request) { return handleGetSVG(dbManager, request); });
         }
         else if (action == "saveSVG") {
-            handleSaveSVG(dbManager, payload, ws);
+            sendResponse(ws, reqId, handleSaveSVG(dbManager, payload));
+        }
+        else if (action == "searchFiles") {
+            handleAsync(workerPool, std::move(payload), ws, [&dbManager](const json& request) { return handleSearchFiles(dbManager, request); });
+        }
+        else if (action == "exportAll") {
+            handleExportAll(dbManager, payload, ws);
+        }
+        else if (action == "importAll") {
+            handleImportAll(payload, ws);
         }
         else {
-            ws->send(R"({"error": "Invalid action"})", uWS::OpCode::TEXT);
+            sendResponse(ws, reqId, { {"error", "Invalid action"} });
             logMessage("Invalid action received: " + action, true);
         }
     }
     catch (const json::exception& e)
     {
         logMessage("JSON parsing error: " + std::string(e.what()), true);
-        ws->send(R"({"error": "Error parsing JSON"})", uWS::OpCode::TEXT);
+        sendResponse(ws, reqId, { {"error", "Error parsing JSON"} });
     }
     catch (const std::exception& e)
     {
         logMessage("Unexpected error: " + std::string(e.what()), true);
-        ws->send(R"({"error": "Internal server error"})", uWS::OpCode::TEXT);
+        sendResponse(ws, reqId, { {"error", "Internal server error"} });
     }
 }
 
@@ -298,34 +703,74 @@ void run_server()
 {
     try
     {
-        SVGDatabaseManager dbManager;
-        AuthDatabaseManager authDbManager;
+        SVGDatabaseManager dbManager(serverConfig.databasePath);
+        AuthDatabaseManager authDbManager(serverConfig.databasePath);
+        WorkerPool workerPool(serverConfig.workerThreads ? serverConfig.workerThreads : std::max(2u, std::thread::hardware_concurrency()));
 
         uWS::App()
             .ws<PerConnectionData>("/*", {
+                .maxPayloadLength = serverConfig.maxPayloadLength,
+                .idleTimeout = serverConfig.idleTimeout,
+                .maxBackpressure = serverConfig.maxBackpressure,
                 .open = [](auto* ws)
                 {
+                    ws->getUserData()->connectionID = nextConnectionID++;
+                    openConnections[ws->getUserData()->connectionID] = ws;
+                    if (trafficCapture)
+                    {
+                        trafficCapture->recordOpen(ws->getUserData()->connectionID);
+                    }
                     logMessage("Connection opened.");
                 },
-                .message = [&dbManager, &authDbManager](auto* ws, std::string_view message, uWS::OpCode opCode)
+                .message = [&dbManager, &authDbManager, &workerPool](auto* ws, std::string_view message, uWS::OpCode opCode)
                 {
+                    if (trafficCapture)
+                    {
+                        trafficCapture->recordFrame(ws->getUserData()->connectionID, static_cast<uint8_t>(opCode), message);
+                    }
+
+                    if (opCode == uWS::OpCode::BINARY)
+                    {
+                        handleBinaryMessage(dbManager, message, ws);
+                        return;
+                    }
+
+                    //Checked before parsing, so an overloaded server sheds work for the cost of a comparison
+                    if (activeRequests >= serverConfig.maxConcurrentRequests)
+                    {
+                        ws->send(busyResponse(message), uWS::OpCode::TEXT);
+                        return;
+                    }
+
                     logMessage("Received message: " + std::string(message));
-                    handleMessage(dbManager, authDbManager, message, ws);
+                    handleMessage(dbManager, authDbManager, workerPool, message, ws);
+                },
+                .drain = [&dbManager](auto* ws)
+                {
+                    if (ws->getUserData()->exportActive)
+                    {
+                        pumpExport(dbManager, ws);
+                    }
                 },
                 .close = [](auto* ws, int code, std::string_view message)
                 {
+                    openConnections.erase(ws->getUserData()->connectionID);
+                    if (trafficCapture)
+                    {
+                        trafficCapture->recordClose(ws->getUserData()->connectionID);
+                    }
                     logMessage("Connection closed. Code: " + std::to_string(code) + ", Message: " + std::string(message));
                 }
                 })
-            .listen(8080, [](auto* token)
+            .listen(serverConfig.port, [](auto* token)
                 {
                     if (token)
                     {
-                        logMessage("Server listening on port 8080.");
+                        logMessage("Server listening on port " + std::to_string(serverConfig.port) + ".");
                     }
                     else
                     {
-                        logMessage("Failed to bind server to port 8080.", true);
+                        logMessage("Failed to bind server to port " + std::to_string(serverConfig.port) + ".", true);
                         throw std::runtime_error("Unable to bind server to port.");
                     }
                 })
@@ -337,8 +782,159 @@ void run_server()
     }
 }
 
-int main()
+int exportToFile(const std::string& username, const std::string& archivePath)
 {
-    run_server();
+    std::ofstream archive(archivePath, std::ios::binary | std::ios::trunc);
+    if (!archive.is_open())
+    {
+        logMessage("Failed to open " + archivePath + " for writing.", true);
+        return 1;
+    }
+
+    SVGDatabaseManager dbManager(serverConfig.databasePath);
+    std::string chunk;
+    std::string cursor;
+    size_t fileCount = 0;
+
+    SVGArchiveWriter::appendHeader(chunk);
+    archive.write(chunk.data(), chunk.size());
+
+    //Each record goes straight to the file, so memory stays at one document however large the account is
+    size_t rowCount = 0;
+    do
+    {
+        rowCount = dbManager.exportSVGs(username, cursor, exportPageSize,
+            [&](const std::string& fileName, const unsigned char* svgData, size_t size)
+            {
+                chunk.clear();
+                SVGArchiveWriter::appendRecord(chunk, fileName, svgData, size);
+                archive.write(chunk.data(), chunk.size());
+                cursor = fileName;
+                return archive.good();
+            });
+
+        fileCount += rowCount;
+    } while (rowCount == exportPageSize && archive.good());
+
+    chunk.clear();
+    SVGArchiveWriter::appendEnd(chunk);
+    archive.write(chunk.data(), chunk.size());
+
+    if (!archive.good())
+    {
+        logMessage("Failed writing archive " + archivePath, true);
+        return 1;
+    }
+
+    logMessage("Exported " + std::to_string(fileCount) + " files for user " + username + " to " + archivePath);
+    return 0;
+}
+
+int importFromFile(const std::string& username, const std::string& archivePath)
+{
+    std::ifstream archive(archivePath, std::ios::binary);
+    if (!archive.is_open())
+    {
+        logMessage("Failed to open " + archivePath + " for reading.", true);
+        return 1;
+    }
+
+    SVGDatabaseManager dbManager(serverConfig.databasePath);
+    SVGArchiveReader reader;
+    SVGArchiveReader::Record record;
+    std::vector<std::pair<std::string, std::vector<unsigned char>>> batch;
+    std::vector<char> buffer(cliReadChunkBytes);
+    size_t fileCount = 0;
+
+    while (!reader.isFinished() && archive)
+    {
+        archive.read(buffer.data(), buffer.size());
+        reader.feed(std::string_view(buffer.data(), static_cast<size_t>(archive.gcount())));
+
+        while (reader.next(record))
+        {
+            batch.emplace_back(std::move(record.fileName), std::move(record.svgData));
+            if (batch.size() >= importBatchSize)
+            {
+                dbManager.importSVGs(username, batch);
+                fileCount += batch.size();
+                batch.clear();
+            }
+        }
+    }
+
+    if (!reader.isFinished())
+    {
+        logMessage("Archive " + archivePath + " is truncated, imported " + std::to_string(fileCount) + " files before the error.", true);
+        return 1;
+    }
+
+    dbManager.importSVGs(username, batch);
+    fileCount += batch.size();
+
+    logMessage("Imported " + std::to_string(fileCount) + " files for user " + username + " from " + archivePath);
     return 0;
 }
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+    std::string configPath = "srsDemoDaemon.json";
+
+    if (args.size() >= 2 && args[0] == "--config")
+    {
+        configPath = args[1];
+        args.erase(args.begin(), args.begin() + 2);
+    }
+
+    try
+    {
+        serverConfig = ServerConfig::load(configPath);
+    }
+    catch (const std::exception& e)
+    {
+        logMessage("Fatal error: " + std::string(e.what()), true);
+        return 1;
+    }
+
+    if (args.empty())
+    {
+        run_server();
+        return 0;
+    }
+
+    const std::string& mode = args[0];
+    if (args.size() == 2 && mode == "--capture")
+    {
+        try
+        {
+            trafficCapture = std::make_unique<TrafficCapture>(args[1]);
+        }
+        catch (const std::exception& e)
+        {
+            logMessage("Fatal error: " + std::string(e.what()), true);
+            return 1;
+        }
+
+        logMessage("Capturing traffic to " + args[1]);
+        run_server();
+        return 0;
+    }
+
+    if (args.size() == 3 && (mode == "--export" || mode == "--import"))
+    {
+        try
+        {
+            return mode == "--export" ? exportToFile(args[1], args[2]) : importFromFile(args[1], args[2]);
+        }
+        catch (const std::exception& e)
+        {
+            logMessage("Fatal error: " + std::string(e.what()), true);
+            return 1;
+        }
+    }
+
+    std::cerr << "Usage: " << argv[0] << " [--config <configFile>]"
+        << " [--capture <traceFile> | --export <userName> <archiveFile> | --import <userName> <archiveFile>]" << std::endl;
+    return 1;
+}
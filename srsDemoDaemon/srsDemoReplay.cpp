@@ -0,0 +1,792 @@
+#include "trafficTrace.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+using SocketHandle = SOCKET;
+constexpr SocketHandle invalidSocket = INVALID_SOCKET;
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+using SocketHandle = int;
+constexpr SocketHandle invalidSocket = -1;
+#endif
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    constexpr uint8_t opText = 0x1;
+    constexpr uint8_t opClose = 0x8;
+    constexpr uint8_t opPing = 0x9;
+    constexpr uint8_t opPong = 0xA;
+
+    //How long a request may go unanswered before the replay counts it as an error and moves on
+    constexpr std::chrono::seconds responseTimeout(10);
+
+    void closeSocket(SocketHandle socket)
+    {
+#ifdef _WIN32
+        closesocket(socket);
+#else
+        close(socket);
+#endif
+    }
+
+    int pollSockets(std::vector<pollfd>& fds, int timeoutMs)
+    {
+#ifdef _WIN32
+        return WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeoutMs);
+#else
+        return poll(fds.data(), fds.size(), timeoutMs);
+#endif
+    }
+
+    std::string base64Encode(const unsigned char* data, size_t size)
+    {
+        static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string out;
+        for (size_t i = 0; i < size; i += 3)
+        {
+            uint32_t chunk = uint32_t(data[i]) << 16;
+            if (i + 1 < size) chunk |= uint32_t(data[i + 1]) << 8;
+            if (i + 2 < size) chunk |= uint32_t(data[i + 2]);
+
+            out.push_back(alphabet[(chunk >> 18) & 0x3F]);
+            out.push_back(alphabet[(chunk >> 12) & 0x3F]);
+            out.push_back(i + 1 < size ? alphabet[(chunk >> 6) & 0x3F] : '=');
+            out.push_back(i + 2 < size ? alphabet[chunk & 0x3F] : '=');
+        }
+        return out;
+    }
+
+    //Whole argument must be a number within range, so a typo is reported instead of replaying against the wrong port
+    bool parseNumber(const char* text, int minimum, int maximum, int& value)
+    {
+        const char* end = text + std::strlen(text);
+        auto [parsedEnd, error] = std::from_chars(text, end, value);
+        return error == std::errc() && parsedEnd == end && value >= minimum && value <= maximum;
+    }
+}
+
+//Just enough of a websocket client to drive the daemon: blocking sends, reads only when poll says so
+class WebSocketClient
+{
+public:
+    WebSocketClient(const std::string& host, int port, std::mt19937& random)
+        : random(random)
+    {
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        addrinfo* addresses = nullptr;
+        if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0)
+        {
+            throw std::runtime_error("Unable to resolve " + host);
+        }
+
+        for (addrinfo* address = addresses; address && socketHandle == invalidSocket; address = address->ai_next)
+        {
+            SocketHandle candidate = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (candidate == invalidSocket)
+            {
+                continue;
+            }
+
+            if (connect(candidate, address->ai_addr, static_cast<int>(address->ai_addrlen)) == 0)
+            {
+                socketHandle = candidate;
+            }
+            else
+            {
+                closeSocket(candidate);
+            }
+        }
+        freeaddrinfo(addresses);
+
+        if (socketHandle == invalidSocket)
+        {
+            throw std::runtime_error("Unable to connect to " + host + ":" + std::to_string(port));
+        }
+
+        int noDelay = 1;
+        setsockopt(socketHandle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+
+        try
+        {
+            handshake(host, port);
+        }
+        catch (...)
+        {
+            closeSocket(socketHandle);
+            throw;
+        }
+    }
+
+    ~WebSocketClient()
+    {
+        if (socketHandle != invalidSocket)
+        {
+            try
+            {
+                send(opClose, "");
+            }
+            catch (...)
+            {
+            }
+            closeSocket(socketHandle);
+        }
+    }
+
+    WebSocketClient(const WebSocketClient&) = delete;
+    WebSocketClient& operator=(const WebSocketClient&) = delete;
+
+    SocketHandle handle() const { return socketHandle; }
+
+    void send(uint8_t opCode, std::string_view payload)
+    {
+        std::string frame;
+        frame.reserve(payload.size() + 14);
+        frame.push_back(static_cast<char>(0x80 | opCode));
+
+        if (payload.size() < 126)
+        {
+            frame.push_back(static_cast<char>(0x80 | payload.size()));
+        }
+        else if (payload.size() <= 0xFFFF)
+        {
+            frame.push_back(static_cast<char>(0x80 | 126));
+            frame.push_back(static_cast<char>((payload.size() >> 8) & 0xFF));
+            frame.push_back(static_cast<char>(payload.size() & 0xFF));
+        }
+        else
+        {
+            frame.push_back(static_cast<char>(0x80 | 127));
+            for (int shift = 56; shift >= 0; shift -= 8)
+            {
+                frame.push_back(static_cast<char>((uint64_t(payload.size()) >> shift) & 0xFF));
+            }
+        }
+
+        //Client frames must be masked
+        char mask[4];
+        for (char& byte : mask)
+        {
+            byte = static_cast<char>(random() & 0xFF);
+        }
+        frame.append(mask, sizeof(mask));
+
+        for (size_t i = 0; i < payload.size(); ++i)
+        {
+            frame.push_back(static_cast<char>(payload[i] ^ mask[i % 4]));
+        }
+
+        sendAll(frame);
+    }
+
+    //Reads what the socket has and appends complete text messages. Returns false once the server closed.
+    bool receive(std::vector<std::string>& textMessages)
+    {
+        char chunk[64 * 1024];
+        int received = recv(socketHandle, chunk, sizeof(chunk), 0);
+        if (received <= 0)
+        {
+            return false;
+        }
+
+        buffer.append(chunk, static_cast<size_t>(received));
+        return parseFrames(textMessages);
+    }
+
+private:
+    SocketHandle socketHandle = invalidSocket;
+    std::mt19937& random;
+    std::string buffer;
+    std::string fragments;
+    uint8_t fragmentOpCode = 0;
+
+    void sendAll(const std::string& data)
+    {
+        size_t sent = 0;
+        while (sent < data.size())
+        {
+            int result = ::send(socketHandle, data.data() + sent, static_cast<int>(std::min<size_t>(data.size() - sent, 1 << 30)), 0);
+            if (result <= 0)
+            {
+                throw std::runtime_error("Socket send failed.");
+            }
+            sent += static_cast<size_t>(result);
+        }
+    }
+
+    void handshake(const std::string& host, int port)
+    {
+        unsigned char keyBytes[16];
+        for (unsigned char& byte : keyBytes)
+        {
+            byte = static_cast<unsigned char>(random() & 0xFF);
+        }
+
+        sendAll("GET / HTTP/1.1\r\n"
+            "Host: " + host + ":" + std::to_string(port) + "\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: Upgrade\r\n"
+            "Sec-WebSocket-Key: " + base64Encode(keyBytes, sizeof(keyBytes)) + "\r\n"
+            "Sec-WebSocket-Version: 13\r\n\r\n");
+
+        size_t headerEnd = std::string::npos;
+        while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos)
+        {
+            char chunk[4096];
+            int received = recv(socketHandle, chunk, sizeof(chunk), 0);
+            if (received <= 0 || buffer.size() > 64 * 1024)
+            {
+                throw std::runtime_error("Websocket handshake failed.");
+            }
+            buffer.append(chunk, static_cast<size_t>(received));
+        }
+
+        if (buffer.compare(0, 12, "HTTP/1.1 101") != 0)
+        {
+            throw std::runtime_error("Server refused websocket upgrade: " + buffer.substr(0, buffer.find("\r\n")));
+        }
+
+        buffer.erase(0, headerEnd + 4);
+    }
+
+    bool parseFrames(std::vector<std::string>& textMessages)
+    {
+        size_t offset = 0;
+        while (buffer.size() - offset >= 2)
+        {
+            const unsigned char* header = reinterpret_cast<const unsigned char*>(buffer.data() + offset);
+            bool finalFrame = (header[0] & 0x80) != 0;
+            uint8_t opCode = header[0] & 0x0F;
+            bool masked = (header[1] & 0x80) != 0;
+            uint64_t length = header[1] & 0x7F;
+            size_t headerSize = 2;
+
+            if (length == 126)
+            {
+                if (buffer.size() - offset < 4) break;
+                length = (uint64_t(header[2]) << 8) | header[3];
+                headerSize = 4;
+            }
+            else if (length == 127)
+            {
+                if (buffer.size() - offset < 10) break;
+                length = 0;
+                for (int i = 0; i < 8; ++i)
+                {
+                    length = (length << 8) | header[2 + i];
+                }
+                headerSize = 10;
+            }
+
+            size_t maskOffset = headerSize;
+            if (masked)
+            {
+                headerSize += 4;
+            }
+
+            if (buffer.size() - offset < headerSize + length)
+            {
+                break;
+            }
+
+            std::string payload = buffer.substr(offset + headerSize, static_cast<size_t>(length));
+            if (masked)
+            {
+                for (size_t i = 0; i < payload.size(); ++i)
+                {
+                    payload[i] = static_cast<char>(payload[i] ^ header[maskOffset + i % 4]);
+                }
+            }
+            offset += headerSize + static_cast<size_t>(length);
+
+            if (opCode == opClose)
+            {
+                return false;
+            }
+
+            if (opCode == opPing)
+            {
+                send(opPong, payload);
+                continue;
+            }
+
+            if (opCode == opPong)
+            {
+                continue;
+            }
+
+            if (opCode != 0)
+            {
+                fragmentOpCode = opCode;
+                fragments.clear();
+            }
+            fragments += payload;
+
+            if (finalFrame)
+            {
+                //Binary frames are export archive data, only the JSON replies matter for timing
+                if (fragmentOpCode == opText)
+                {
+                    textMessages.push_back(std::move(fragments));
+                }
+                fragments.clear();
+            }
+        }
+
+        buffer.erase(0, offset);
+        return true;
+    }
+};
+
+struct ReplayOptions
+{
+    std::string tracePath;
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    bool fast = false;
+    bool createUsers = true;
+    std::string password = "replay";
+    size_t window = 16;
+};
+
+class Replayer
+{
+public:
+    explicit Replayer(const ReplayOptions& options)
+        : options(options), random(12345)
+    {
+    }
+
+    void run()
+    {
+        TraceReader reader(options.tracePath);
+        TraceRecord record;
+
+        replayStart = Clock::now();
+        while (reader.next(record))
+        {
+            if (!options.fast)
+            {
+                Clock::time_point due = replayStart + std::chrono::microseconds(record.timestampMicros);
+                while (Clock::now() < due)
+                {
+                    pump(static_cast<int>(std::max<long long>(1, std::chrono::duration_cast<std::chrono::milliseconds>(due - Clock::now()).count())));
+                }
+            }
+
+            switch (record.type)
+            {
+            case TraceRecordType::Open:
+                connections[record.connectionID].client = std::make_unique<WebSocketClient>(options.host, options.port, random);
+                break;
+
+            case TraceRecordType::Close:
+                closeConnection(record.connectionID);
+                break;
+
+            case TraceRecordType::SessionIssued:
+            {
+                auto it = connections.find(record.connectionID);
+                if (it != connections.end() && !it->second.lastIssuedSession.empty())
+                {
+                    sessionBindings[record.data] = it->second.lastIssuedSession;
+                }
+                break;
+            }
+
+            case TraceRecordType::Frame:
+                replayFrame(record);
+                break;
+            }
+        }
+
+        for (auto& [connectionID, connection] : connections)
+        {
+            drain(connection, std::chrono::seconds(30));
+        }
+        replayEnd = Clock::now();
+        connections.clear();
+    }
+
+    void report() const
+    {
+        double seconds = std::chrono::duration<double>(replayEnd - replayStart).count();
+        size_t totalRequests = 0;
+
+        std::cout << std::left << std::setw(16) << "action" << std::right
+            << std::setw(9) << "count" << std::setw(9) << "errors"
+            << std::setw(11) << "mean ms" << std::setw(11) << "p50 ms" << std::setw(11) << "p95 ms"
+            << std::setw(11) << "p99 ms" << std::setw(11) << "max ms" << std::endl;
+
+        for (const auto& [action, stats] : actionStats)
+        {
+            std::vector<double> latencies = stats.latenciesMicros;
+            std::sort(latencies.begin(), latencies.end());
+            totalRequests += latencies.size();
+
+            double sum = 0;
+            for (double latency : latencies)
+            {
+                sum += latency;
+            }
+
+            auto percentile = [&](double p)
+            {
+                return latencies.empty() ? 0.0 : latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))] / 1000.0;
+            };
+
+            std::cout << std::left << std::setw(16) << action << std::right << std::fixed << std::setprecision(3)
+                << std::setw(9) << latencies.size() << std::setw(9) << stats.errors
+                << std::setw(11) << (latencies.empty() ? 0.0 : sum / latencies.size() / 1000.0)
+                << std::setw(11) << percentile(0.50) << std::setw(11) << percentile(0.95)
+                << std::setw(11) << percentile(0.99) << std::setw(11) << (latencies.empty() ? 0.0 : latencies.back() / 1000.0)
+                << std::endl;
+        }
+
+        std::cout << std::fixed << std::setprecision(3) << totalRequests << " responses in " << seconds << " s, "
+            << (seconds > 0 ? totalRequests / seconds : 0.0) << " requests/s" << std::endl;
+    }
+
+private:
+    struct PendingRequest
+    {
+        std::string action;
+        Clock::time_point sentAt;
+        bool tracked = true;
+    };
+
+    struct ReplayConnection
+    {
+        std::unique_ptr<WebSocketClient> client;
+        std::unordered_map<uint64_t, PendingRequest> pending;
+        std::string lastIssuedSession;
+    };
+
+    struct ActionStats
+    {
+        std::vector<double> latenciesMicros;
+        size_t errors = 0;
+    };
+
+    ReplayOptions options;
+    std::mt19937 random;
+    std::map<uint64_t, ReplayConnection> connections;
+    std::unordered_map<std::string, std::string> sessionBindings;
+    std::unordered_set<std::string> createdUsers;
+    std::map<std::string, ActionStats> actionStats;
+    uint64_t nextReqId = 1;
+    Clock::time_point replayStart;
+    Clock::time_point replayEnd;
+
+    uint64_t sendRequest(ReplayConnection& connection, json payload, bool tracked)
+    {
+        uint64_t reqId = nextReqId++;
+        payload["reqId"] = reqId;
+        connection.pending[reqId] = { payload.value("action", ""), Clock::now(), tracked };
+        connection.client->send(opText, payload.dump());
+        return reqId;
+    }
+
+    //Returns the response, or a null json if the connection dropped or the deadline passed
+    json sendAndWait(ReplayConnection& connection, json payload, bool tracked)
+    {
+        uint64_t reqId = sendRequest(connection, std::move(payload), tracked);
+
+        Clock::time_point deadline = Clock::now() + responseTimeout;
+        while (connection.client && connection.pending.count(reqId) && Clock::now() < deadline)
+        {
+            pump(10);
+        }
+
+        auto it = lastResponses.find(reqId);
+        if (it == lastResponses.end())
+        {
+            return json();
+        }
+
+        json response = std::move(it->second);
+        lastResponses.erase(it);
+        return response;
+    }
+
+    //Responses to login style requests, which the replay has to inspect before continuing
+    std::unordered_map<uint64_t, json> lastResponses;
+
+    void replayFrame(const TraceRecord& record)
+    {
+        auto it = connections.find(record.connectionID);
+        if (it == connections.end() || !it->second.client)
+        {
+            return;
+        }
+        ReplayConnection& connection = it->second;
+
+        json payload = record.opCode == opText ? json::parse(record.data, nullptr, false) : json();
+        if (!payload.is_object() || !payload.contains("action") || !payload["action"].is_string())
+        {
+            connection.client->send(record.opCode, record.data);
+            return;
+        }
+
+        Clock::time_point deadline = Clock::now() + responseTimeout;
+        while (connection.client && connection.pending.size() >= options.window && Clock::now() < deadline)
+        {
+            pump(10);
+        }
+        if (connection.client && connection.pending.size() >= options.window)
+        {
+            //Requests the server dropped or never answered would otherwise hold the window shut for good
+            abandonPending(connection);
+        }
+        if (!connection.client)
+        {
+            return;
+        }
+
+        if (payload.contains("password") && payload["password"].is_string() && payload["password"].get<std::string>() == redactedPassword)
+        {
+            payload["password"] = options.password;
+        }
+
+        if (payload.contains("sessionId") && payload["sessionId"].is_string())
+        {
+            auto binding = sessionBindings.find(payload["sessionId"].get<std::string>());
+            if (binding != sessionBindings.end())
+            {
+                payload["sessionId"] = binding->second;
+            }
+        }
+
+        std::string action = payload["action"];
+        if (action != "login" && action != "createUser")
+        {
+            sendRequest(connection, std::move(payload), true);
+            return;
+        }
+
+        //Session aliases bind to whatever the next SessionIssued record names, so wait for the session to exist
+        std::string username = payload.value("username", "");
+        if (action == "login" && options.createUsers && createdUsers.insert(username).second)
+        {
+            sendAndWait(connection, { {"action", "createUser"}, {"username", username}, {"password", payload["password"]} }, false);
+        }
+
+        json response = sendAndWait(connection, payload, true);
+        if (action == "createUser" && response.contains("error") && options.createUsers)
+        {
+            //Left over from an earlier replay against the same database
+            payload["action"] = "login";
+            sendAndWait(connection, payload, false);
+        }
+    }
+
+    void handleMessage(ReplayConnection& connection, const std::string& message)
+    {
+        json response = json::parse(message, nullptr, false);
+        if (!response.is_object() || !response.contains("reqId") || !response["reqId"].is_number_unsigned())
+        {
+            return;
+        }
+
+        uint64_t reqId = response["reqId"].get<uint64_t>();
+        auto it = connection.pending.find(reqId);
+        if (it == connection.pending.end())
+        {
+            return;
+        }
+
+        if (it->second.tracked)
+        {
+            ActionStats& stats = actionStats[it->second.action];
+            stats.latenciesMicros.push_back(std::chrono::duration<double, std::micro>(Clock::now() - it->second.sentAt).count());
+            if (response.contains("error"))
+            {
+                ++stats.errors;
+            }
+        }
+
+        if (response.contains("sessionId") && response["sessionId"].is_string())
+        {
+            connection.lastIssuedSession = response["sessionId"].get<std::string>();
+        }
+
+        if (it->second.action == "login" || it->second.action == "createUser")
+        {
+            lastResponses[reqId] = response;
+        }
+
+        connection.pending.erase(it);
+    }
+
+    //Counts every outstanding request as an error, a late response to one of them is ignored
+    void abandonPending(ReplayConnection& connection)
+    {
+        for (const auto& [reqId, request] : connection.pending)
+        {
+            if (request.tracked)
+            {
+                ++actionStats[request.action].errors;
+            }
+        }
+        connection.pending.clear();
+    }
+
+    void dropConnection(ReplayConnection& connection)
+    {
+        abandonPending(connection);
+        connection.client.reset();
+    }
+
+    void pump(int timeoutMs)
+    {
+        std::vector<pollfd> fds;
+        std::vector<ReplayConnection*> owners;
+        for (auto& [connectionID, connection] : connections)
+        {
+            if (connection.client)
+            {
+                fds.push_back({ connection.client->handle(), POLLIN, 0 });
+                owners.push_back(&connection);
+            }
+        }
+
+        if (fds.empty())
+        {
+            return;
+        }
+
+        if (pollSockets(fds, timeoutMs) <= 0)
+        {
+            return;
+        }
+
+        for (size_t i = 0; i < fds.size(); ++i)
+        {
+            if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) == 0)
+            {
+                continue;
+            }
+
+            std::vector<std::string> messages;
+            bool open = owners[i]->client->receive(messages);
+            for (const std::string& message : messages)
+            {
+                handleMessage(*owners[i], message);
+            }
+
+            if (!open)
+            {
+                dropConnection(*owners[i]);
+            }
+        }
+    }
+
+    void drain(ReplayConnection& connection, std::chrono::seconds timeout)
+    {
+        Clock::time_point deadline = Clock::now() + timeout;
+        while (connection.client && !connection.pending.empty() && Clock::now() < deadline)
+        {
+            pump(10);
+        }
+
+        if (connection.client)
+        {
+            dropConnection(connection);
+        }
+    }
+
+    void closeConnection(uint64_t connectionID)
+    {
+        auto it = connections.find(connectionID);
+        if (it == connections.end())
+        {
+            return;
+        }
+
+        drain(it->second, std::chrono::seconds(10));
+        connections.erase(it);
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    ReplayOptions options;
+    bool valid = argc >= 2;
+
+    for (int i = 1; i < argc && valid; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--fast") options.fast = true;
+        else if (arg == "--no-create-users") options.createUsers = false;
+        else if (arg == "--host" && hasValue) options.host = argv[++i];
+        else if (arg == "--port" && hasValue) valid = parseNumber(argv[++i], 1, 65535, options.port);
+        else if (arg == "--password" && hasValue) options.password = argv[++i];
+        else if (arg == "--window" && hasValue)
+        {
+            int window = 0;
+            valid = parseNumber(argv[++i], 1, 65535, window);
+            options.window = static_cast<size_t>(window);
+        }
+        else if (options.tracePath.empty() && arg.rfind("--", 0) != 0) options.tracePath = arg;
+        else valid = false;
+    }
+
+    if (!valid || options.tracePath.empty())
+    {
+        std::cerr << "Usage: " << argv[0] << " <traceFile> [--fast] [--host <host>] [--port <port>]"
+            << " [--password <password>] [--window <requestsInFlight>] [--no-create-users]" << std::endl;
+        return 1;
+    }
+
+#ifdef _WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+    int result = 0;
+    try
+    {
+        Replayer replayer(options);
+        replayer.run();
+        replayer.report();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Replay failed: " << e.what() << std::endl;
+        result = 1;
+    }
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+
+    return result;
+}
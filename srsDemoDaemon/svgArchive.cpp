@@ -0,0 +1,161 @@
+#include "svgArchive.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    constexpr char archiveMagic[4] = { 'S', 'R', 'S', 'A' };
+    constexpr uint32_t archiveVersion = 1;
+    constexpr uint32_t maxFileNameLength = 4096;
+    constexpr uint32_t maxRecordSize = 64 * 1024 * 1024;
+
+    void appendU32(std::string& out, uint32_t value)
+    {
+        char bytes[4] = {
+            static_cast<char>(value & 0xFF),
+            static_cast<char>((value >> 8) & 0xFF),
+            static_cast<char>((value >> 16) & 0xFF),
+            static_cast<char>((value >> 24) & 0xFF)
+        };
+        out.append(bytes, sizeof(bytes));
+    }
+
+    uint32_t decodeU32(const char* bytes)
+    {
+        const unsigned char* b = reinterpret_cast<const unsigned char*>(bytes);
+        return uint32_t(b[0]) | (uint32_t(b[1]) << 8) | (uint32_t(b[2]) << 16) | (uint32_t(b[3]) << 24);
+    }
+}
+
+void SVGArchiveWriter::appendHeader(std::string& out)
+{
+    out.append(archiveMagic, sizeof(archiveMagic));
+    appendU32(out, archiveVersion);
+}
+
+void SVGArchiveWriter::appendRecord(std::string& out, const std::string& fileName, const unsigned char* data, size_t size)
+{
+    if (fileName.empty() || fileName.size() > maxFileNameLength || size > maxRecordSize)
+    {
+        throw std::invalid_argument("Archive record for '" + fileName + "' is out of bounds.");
+    }
+
+    out.reserve(out.size() + 8 + fileName.size() + size);
+    appendU32(out, static_cast<uint32_t>(fileName.size()));
+    out.append(fileName);
+    appendU32(out, static_cast<uint32_t>(size));
+    out.append(reinterpret_cast<const char*>(data), size);
+}
+
+void SVGArchiveWriter::appendEnd(std::string& out)
+{
+    appendU32(out, 0);
+}
+
+void SVGArchiveReader::feed(std::string_view chunk)
+{
+    if (finished && !chunk.empty())
+    {
+        throw std::runtime_error("Archive data received after end marker.");
+    }
+
+    buffer.append(chunk.data(), chunk.size());
+}
+
+bool SVGArchiveReader::readU32(uint32_t& value)
+{
+    if (buffer.size() - offset < 4)
+    {
+        return false;
+    }
+
+    value = decodeU32(buffer.data() + offset);
+    offset += 4;
+    return true;
+}
+
+void SVGArchiveReader::compact()
+{
+    //Drop consumed bytes once they dominate the buffer, keeps memory bounded by the largest record
+    if (offset > 0 && offset * 2 >= buffer.size())
+    {
+        buffer.erase(0, offset);
+        offset = 0;
+    }
+}
+
+bool SVGArchiveReader::next(Record& record)
+{
+    if (finished)
+    {
+        return false;
+    }
+
+    if (!headerRead)
+    {
+        if (buffer.size() - offset < sizeof(archiveMagic) + 4)
+        {
+            return false;
+        }
+
+        if (std::memcmp(buffer.data() + offset, archiveMagic, sizeof(archiveMagic)) != 0)
+        {
+            throw std::runtime_error("Not an SRS archive.");
+        }
+
+        if (decodeU32(buffer.data() + offset + sizeof(archiveMagic)) != archiveVersion)
+        {
+            throw std::runtime_error("Unsupported archive version.");
+        }
+
+        offset += sizeof(archiveMagic) + 4;
+        headerRead = true;
+    }
+
+    size_t start = offset;
+    uint32_t nameLength = 0;
+    if (!readU32(nameLength))
+    {
+        return false;
+    }
+
+    if (nameLength == 0)
+    {
+        finished = true;
+        compact();
+        return false;
+    }
+
+    if (nameLength > maxFileNameLength)
+    {
+        throw std::runtime_error("Archive record has an invalid file name length.");
+    }
+
+    if (buffer.size() - offset < nameLength + 4)
+    {
+        offset = start;
+        return false;
+    }
+
+    uint32_t dataLength = decodeU32(buffer.data() + offset + nameLength);
+    if (dataLength > maxRecordSize)
+    {
+        throw std::runtime_error("Archive record exceeds the maximum document size.");
+    }
+
+    if (buffer.size() - offset < size_t(nameLength) + 4 + dataLength)
+    {
+        offset = start;
+        return false;
+    }
+
+    record.fileName.assign(buffer.data() + offset, nameLength);
+    offset += nameLength + 4;
+
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(buffer.data() + offset);
+    record.svgData.assign(data, data + dataLength);
+    offset += dataLength;
+
+    compact();
+    return true;
+}
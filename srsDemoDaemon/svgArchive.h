@@ -0,0 +1,48 @@
+#ifndef SVGARCHIVE_H
+#define SVGARCHIVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//Archive layout: "SRSA" + u32 version, then one record per document
+//(u32 nameLength, name, u32 dataLength, data), closed by a record with nameLength 0.
+//All integers are little endian. One header and one end marker per archive, nothing may follow the end marker.
+class SVGArchiveWriter
+{
+public:
+    static void appendHeader(std::string& out);
+    static void appendRecord(std::string& out, const std::string& fileName, const unsigned char* data, size_t size);
+    static void appendEnd(std::string& out);
+};
+
+//Incremental parser, so archives can be fed in whatever pieces arrive from a socket or file
+class SVGArchiveReader
+{
+public:
+    struct Record
+    {
+        std::string fileName;
+        std::vector<unsigned char> svgData;
+    };
+
+    void feed(std::string_view chunk);
+
+    //Returns true and fills record when a complete record is buffered. Throws on malformed input.
+    bool next(Record& record);
+
+    bool isFinished() const { return finished; }
+
+private:
+    std::string buffer;
+    size_t offset = 0;
+    bool headerRead = false;
+    bool finished = false;
+
+    bool readU32(uint32_t& value);
+    void compact();
+};
+
+#endif // SVGARCHIVE_H
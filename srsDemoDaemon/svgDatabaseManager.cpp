@@ -1,25 +1,39 @@
 #include "SVGDatabaseManager.h"
+#include "sqliteConnection.h"
 #include <sqlite3.h>
+#include <tinyxml2.h>
+#include <cctype>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 #include <vector>
 
-SVGDatabaseManager::SVGDatabaseManager()
+SVGDatabaseManager::SVGDatabaseManager(const std::string& databasePath)
+    : databasePath(databasePath)
 {
     initializeDatabase();
 }
 
-SVGDatabaseManager::~SVGDatabaseManager() = default;
+SVGDatabaseManager::~SVGDatabaseManager()
+{
+    sqlite3_finalize(searchStmt);
+    sqlite3_close(searchDb);
+}
 
 void SVGDatabaseManager::initializeDatabase()
 {
-    databasePath = "srs_database.db";
-    sqlite3* db = nullptr;
+    sqlite3* db = openDatabase(databasePath);
 
-    if (sqlite3_open(databasePath.c_str(), &db) != SQLITE_OK)
+    //WAL lets the worker pool keep reading while the event loop commits. The mode is stored in the file,
+    //so it also covers the users table and every later connection.
+    char* errorMessage = nullptr;
+    if (sqlite3_exec(db, "PRAGMA journal_mode=WAL;", nullptr, nullptr, &errorMessage) != SQLITE_OK)
     {
-        throw std::runtime_error("Error opening database: " + std::string(sqlite3_errmsg(db)));
+        std::ostringstream errMsg;
+        errMsg << "Error enabling WAL: " << errorMessage;
+        sqlite3_free(errorMessage);
+        sqlite3_close(db);
+        throw std::runtime_error(errMsg.str());
     }
 
     const char* createTableSQL = R"(
@@ -33,7 +47,6 @@ void SVGDatabaseManager::initializeDatabase()
         );
     )";
 
-    char* errorMessage = nullptr;
     if (sqlite3_exec(db, createTableSQL, nullptr, nullptr, &errorMessage) != SQLITE_OK)
     {
         std::ostringstream errMsg;
@@ -43,49 +56,163 @@ void SVGDatabaseManager::initializeDatabase()
         throw std::runtime_error(errMsg.str());
     }
 
+    //Rowids mirror svg_data, so an index entry can be replaced without scanning the index
+    const char* createSearchSQL = R"(
+        CREATE VIRTUAL TABLE IF NOT EXISTS svg_search USING fts5(
+            userName,
+            fileName,
+            content,
+            tokenize = 'unicode61',
+            prefix = '2 3'
+        );
+    )";
+
+    if (sqlite3_exec(db, createSearchSQL, nullptr, nullptr, &errorMessage) != SQLITE_OK)
+    {
+        std::ostringstream errMsg;
+        errMsg << "Error creating search index: " << errorMessage;
+        sqlite3_free(errorMessage);
+        sqlite3_close(db);
+        throw std::runtime_error(errMsg.str());
+    }
+
+    try
+    {
+        backfillSearchIndex(db);
+    }
+    catch (...)
+    {
+        sqlite3_close(db);
+        throw;
+    }
+
     sqlite3_close(db);
 }
 
-void SVGDatabaseManager::saveSVG(const std::string& fileName, const std::string& userName, const std::vector<unsigned char>& svgData)
+void SVGDatabaseManager::backfillSearchIndex(sqlite3* db)
 {
-    if (fileName.empty() || svgData.empty() || userName.empty())
+    //Indexes documents saved before the search index existed
+    const char* selectSQL = R"(
+        SELECT rowid, userName, fileName, svgData FROM svg_data
+        WHERE rowid NOT IN (SELECT rowid FROM svg_search);
+    )";
+
+    const char* indexSQL = R"(
+        INSERT INTO svg_search (rowid, userName, fileName, content)
+        VALUES (?, ?, ?, ?);
+    )";
+
+    sqlite3_stmt* selectStmt = nullptr;
+    sqlite3_stmt* indexStmt = nullptr;
+    if (sqlite3_prepare_v2(db, selectSQL, -1, &selectStmt, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, indexSQL, -1, &indexStmt, nullptr) != SQLITE_OK)
     {
-        throw std::invalid_argument("File name, user name, or SVG data cannot be empty.");
+        std::string error = sqlite3_errmsg(db);
+        sqlite3_finalize(selectStmt);
+        throw std::runtime_error("Error preparing statement: " + error);
     }
 
-    sqlite3* db = nullptr;
-    if (sqlite3_open(databasePath.c_str(), &db) != SQLITE_OK)
+    if (sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) != SQLITE_OK)
     {
-        throw std::runtime_error("Error opening database: " + std::string(sqlite3_errmsg(db)));
+        std::string error = sqlite3_errmsg(db);
+        sqlite3_finalize(indexStmt);
+        sqlite3_finalize(selectStmt);
+        throw std::runtime_error("Error beginning transaction: " + error);
     }
 
-    const char* insertSQL = R"(
-        INSERT OR REPLACE INTO svg_data (userName, fileName, svgData)
-        VALUES (?, ?, ?);
-    )";
+    int stepResult = SQLITE_DONE;
+    while ((stepResult = sqlite3_step(selectStmt)) == SQLITE_ROW)
+    {
+        const unsigned char* blobData = static_cast<const unsigned char*>(sqlite3_column_blob(selectStmt, 3));
+        std::string content = extractSearchText(blobData, static_cast<size_t>(sqlite3_column_bytes(selectStmt, 3)));
 
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, insertSQL, -1, &stmt, nullptr) != SQLITE_OK)
+        sqlite3_bind_int64(indexStmt, 1, sqlite3_column_int64(selectStmt, 0));
+        sqlite3_bind_text(indexStmt, 2, reinterpret_cast<const char*>(sqlite3_column_text(selectStmt, 1)), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(indexStmt, 3, reinterpret_cast<const char*>(sqlite3_column_text(selectStmt, 2)), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(indexStmt, 4, content.c_str(), -1, SQLITE_STATIC);
+
+        if (sqlite3_step(indexStmt) != SQLITE_DONE)
+        {
+            std::string error = sqlite3_errmsg(db);
+            sqlite3_finalize(indexStmt);
+            sqlite3_finalize(selectStmt);
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            throw std::runtime_error("Error indexing document: " + error);
+        }
+
+        sqlite3_reset(indexStmt);
+    }
+
+    std::string error = sqlite3_errmsg(db);
+    sqlite3_finalize(indexStmt);
+    sqlite3_finalize(selectStmt);
+
+    if (stepResult != SQLITE_DONE)
     {
-        sqlite3_close(db);
-        throw std::runtime_error("Error preparing statement: " + std::string(sqlite3_errmsg(db)));
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        throw std::runtime_error("Error reading documents to index: " + error);
     }
 
-    sqlite3_bind_text(stmt, 1, userName.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, fileName.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_blob(stmt, 3, svgData.data(), (int)svgData.size(), SQLITE_STATIC);
+    if (sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK)
+    {
+        error = sqlite3_errmsg(db);
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        throw std::runtime_error("Error committing search index: " + error);
+    }
+}
 
-    if (sqlite3_step(stmt) != SQLITE_DONE)
+std::string SVGDatabaseManager::extractSearchText(const unsigned char* svgData, size_t size)
+{
+    tinyxml2::XMLDocument doc;
+    if (doc.Parse(reinterpret_cast<const char*>(svgData), size) != tinyxml2::XML_SUCCESS)
     {
-        std::ostringstream errMsg;
-        errMsg << "Error executing statement: " << sqlite3_errmsg(db);
-        sqlite3_finalize(stmt);
-        sqlite3_close(db);
-        throw std::runtime_error(errMsg.str());
+        return "";
     }
 
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
+    //Element names, text and non-numeric attribute values, so "circle" or "red" find a document but coordinates do not
+    std::string content;
+    std::vector<const tinyxml2::XMLNode*> pending = { &doc };
+    while (!pending.empty())
+    {
+        const tinyxml2::XMLNode* node = pending.back();
+        pending.pop_back();
+
+        if (const tinyxml2::XMLElement* element = node->ToElement())
+        {
+            content.append(element->Name()).push_back(' ');
+            for (const tinyxml2::XMLAttribute* attribute = element->FirstAttribute(); attribute; attribute = attribute->Next())
+            {
+                std::string value = attribute->Value();
+                bool numeric = !value.empty() && (std::isdigit(static_cast<unsigned char>(value[0])) || value[0] == '-' || value[0] == '.');
+                if (!numeric)
+                {
+                    content.append(value).push_back(' ');
+                }
+            }
+        }
+        else if (node->ToText())
+        {
+            content.append(node->Value()).push_back(' ');
+        }
+
+        for (const tinyxml2::XMLNode* child = node->FirstChild(); child; child = child->NextSibling())
+        {
+            pending.push_back(child);
+        }
+    }
+
+    return content;
+}
+
+void SVGDatabaseManager::saveSVG(const std::string& fileName, const std::string& userName, const std::vector<unsigned char>& svgData)
+{
+    if (fileName.empty() || svgData.empty() || userName.empty())
+    {
+        throw std::invalid_argument("File name, user name, or SVG data cannot be empty.");
+    }
+
+    //Same transaction as a bulk import, so the document and its search entry change together
+    importSVGs(userName, { { fileName, svgData } });
 }
 
 std::vector<unsigned char> SVGDatabaseManager::getSVG(const std::string& fileName, const std::string& userName)
@@ -95,11 +222,7 @@ std::vector<unsigned char> SVGDatabaseManager::getSVG(const std::string& fileNam
         throw std::invalid_argument("File name or user name cannot be empty.");
     }
 
-    sqlite3* db = nullptr;
-    if (sqlite3_open(databasePath.c_str(), &db) != SQLITE_OK)
-    {
-        throw std::runtime_error("Error opening database: " + std::string(sqlite3_errmsg(db)));
-    }
+    sqlite3* db = openDatabase(databasePath);
 
     const char* selectSQL = R"(
         SELECT svgData FROM svg_data WHERE userName = ? AND fileName = ?;
@@ -116,7 +239,8 @@ std::vector<unsigned char> SVGDatabaseManager::getSVG(const std::string& fileNam
     sqlite3_bind_text(stmt, 2, fileName.c_str(), -1, SQLITE_STATIC);
 
     std::vector<unsigned char> svgData;
-    if (sqlite3_step(stmt) == SQLITE_ROW)
+    int stepResult = sqlite3_step(stmt);
+    if (stepResult == SQLITE_ROW)
     {
         const void* blobData = sqlite3_column_blob(stmt, 0);
         int blobSize = sqlite3_column_bytes(stmt, 0);
@@ -124,9 +248,14 @@ std::vector<unsigned char> SVGDatabaseManager::getSVG(const std::string& fileNam
     }
     else
     {
+        std::string error = sqlite3_errmsg(db);
         sqlite3_finalize(stmt);
         sqlite3_close(db);
-        throw std::runtime_error("No SVG data found for userName and fileName.");
+        if (stepResult == SQLITE_DONE)
+        {
+            throw std::runtime_error("No SVG data found for userName and fileName.");
+        }
+        throw std::runtime_error("Error reading SVG data: " + error);
     }
 
     sqlite3_finalize(stmt);
@@ -142,11 +271,7 @@ std::vector<std::string> SVGDatabaseManager::getFileList(const std::string& user
         throw std::invalid_argument("User name cannot be empty.");
     }
 
-    sqlite3* db = nullptr;
-    if (sqlite3_open(databasePath.c_str(), &db) != SQLITE_OK)
-    {
-        throw std::runtime_error("Error opening database: " + std::string(sqlite3_errmsg(db)));
-    }
+    sqlite3* db = openDatabase(databasePath);
 
     const char* selectSQL = R"(
         SELECT fileName FROM svg_data WHERE userName = ? ORDER BY timestamp DESC;
@@ -162,14 +287,308 @@ std::vector<std::string> SVGDatabaseManager::getFileList(const std::string& user
     sqlite3_bind_text(stmt, 1, userName.c_str(), -1, SQLITE_STATIC);
 
     std::vector<std::string> fileList;
-    while (sqlite3_step(stmt) == SQLITE_ROW)
+    int stepResult = SQLITE_DONE;
+    while ((stepResult = sqlite3_step(stmt)) == SQLITE_ROW)
     {
         const char* fileName = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
         fileList.emplace_back(fileName);
     }
 
+    std::string error = sqlite3_errmsg(db);
     sqlite3_finalize(stmt);
     sqlite3_close(db);
 
+    //A short list would look like deleted files to the client
+    if (stepResult != SQLITE_DONE)
+    {
+        throw std::runtime_error("Error reading file list: " + error);
+    }
+
+    return fileList;
+}
+
+size_t SVGDatabaseManager::exportSVGs(const std::string& userName, const std::string& afterFileName, size_t limit,
+    const std::function<bool(const std::string& fileName, const unsigned char* data, size_t size)>& onRow)
+{
+    if (userName.empty())
+    {
+        throw std::invalid_argument("User name cannot be empty.");
+    }
+
+    sqlite3* db = openDatabase(databasePath);
+
+    //Keyset pagination on the primary key, so every page is an index seek and nothing is held between pages
+    const char* selectSQL = R"(
+        SELECT fileName, svgData FROM svg_data
+        WHERE userName = ? AND fileName > ?
+        ORDER BY fileName
+        LIMIT ?;
+    )";
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, selectSQL, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        sqlite3_close(db);
+        throw std::runtime_error("Error preparing statement: " + std::string(sqlite3_errmsg(db)));
+    }
+
+    sqlite3_bind_text(stmt, 1, userName.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, afterFileName.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 3, static_cast<sqlite3_int64>(limit));
+
+    size_t rowCount = 0;
+    int stepResult = SQLITE_DONE;
+    while ((stepResult = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        ++rowCount;
+        std::string fileName = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        const unsigned char* blobData = static_cast<const unsigned char*>(sqlite3_column_blob(stmt, 1));
+        int blobSize = sqlite3_column_bytes(stmt, 1);
+
+        if (!onRow(fileName, blobData, static_cast<size_t>(blobSize)))
+        {
+            stepResult = SQLITE_DONE;
+            break;
+        }
+    }
+
+    std::string error = sqlite3_errmsg(db);
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+
+    if (stepResult != SQLITE_DONE)
+    {
+        throw std::runtime_error("Error reading documents: " + error);
+    }
+
+    return rowCount;
+}
+
+void SVGDatabaseManager::importSVGs(const std::string& userName, const std::vector<std::pair<std::string, std::vector<unsigned char>>>& files)
+{
+    if (userName.empty())
+    {
+        throw std::invalid_argument("User name cannot be empty.");
+    }
+
+    if (files.empty())
+    {
+        return;
+    }
+
+    sqlite3* db = openDatabase(databasePath);
+
+    char* errorMessage = nullptr;
+    if (sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, &errorMessage) != SQLITE_OK)
+    {
+        std::ostringstream errMsg;
+        errMsg << "Error beginning transaction: " << errorMessage;
+        sqlite3_free(errorMessage);
+        sqlite3_close(db);
+        throw std::runtime_error(errMsg.str());
+    }
+
+    const char* unindexSQL = R"(
+        DELETE FROM svg_search
+        WHERE rowid = (SELECT rowid FROM svg_data WHERE userName = ? AND fileName = ?);
+    )";
+
+    const char* insertSQL = R"(
+        INSERT OR REPLACE INTO svg_data (userName, fileName, svgData)
+        VALUES (?, ?, ?);
+    )";
+
+    const char* indexSQL = R"(
+        INSERT INTO svg_search (rowid, userName, fileName, content)
+        VALUES (?, ?, ?, ?);
+    )";
+
+    sqlite3_stmt* unindexStmt = nullptr;
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_stmt* indexStmt = nullptr;
+    auto finalizeAll = [&]()
+    {
+        sqlite3_finalize(unindexStmt);
+        sqlite3_finalize(stmt);
+        sqlite3_finalize(indexStmt);
+    };
+
+    if (sqlite3_prepare_v2(db, unindexSQL, -1, &unindexStmt, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, insertSQL, -1, &stmt, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, indexSQL, -1, &indexStmt, nullptr) != SQLITE_OK)
+    {
+        std::string error = sqlite3_errmsg(db);
+        finalizeAll();
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        sqlite3_close(db);
+        throw std::runtime_error("Error preparing statement: " + error);
+    }
+
+    for (const auto& [fileName, svgData] : files)
+    {
+        if (fileName.empty() || svgData.empty())
+        {
+            finalizeAll();
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            sqlite3_close(db);
+            throw std::invalid_argument("File name or SVG data cannot be empty.");
+        }
+
+        std::string content = extractSearchText(svgData.data(), svgData.size());
+
+        sqlite3_bind_text(unindexStmt, 1, userName.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(unindexStmt, 2, fileName.c_str(), -1, SQLITE_STATIC);
+
+        sqlite3_bind_text(stmt, 1, userName.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, fileName.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_blob(stmt, 3, svgData.data(), (int)svgData.size(), SQLITE_STATIC);
+
+        bool stepped = sqlite3_step(unindexStmt) == SQLITE_DONE && sqlite3_step(stmt) == SQLITE_DONE;
+        if (stepped)
+        {
+            sqlite3_bind_int64(indexStmt, 1, sqlite3_last_insert_rowid(db));
+            sqlite3_bind_text(indexStmt, 2, userName.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(indexStmt, 3, fileName.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(indexStmt, 4, content.c_str(), -1, SQLITE_STATIC);
+            stepped = sqlite3_step(indexStmt) == SQLITE_DONE;
+        }
+
+        if (!stepped)
+        {
+            std::ostringstream errMsg;
+            errMsg << "Error executing statement: " << sqlite3_errmsg(db);
+            finalizeAll();
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            sqlite3_close(db);
+            throw std::runtime_error(errMsg.str());
+        }
+
+        sqlite3_reset(unindexStmt);
+        sqlite3_reset(stmt);
+        sqlite3_reset(indexStmt);
+    }
+
+    finalizeAll();
+
+    if (sqlite3_exec(db, "COMMIT;", nullptr, nullptr, &errorMessage) != SQLITE_OK)
+    {
+        std::ostringstream errMsg;
+        errMsg << "Error committing transaction: " << errorMessage;
+        sqlite3_free(errorMessage);
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        sqlite3_close(db);
+        throw std::runtime_error(errMsg.str());
+    }
+
+    sqlite3_close(db);
+}
+
+std::vector<std::string> SVGDatabaseManager::searchFiles(const std::string& userName, const std::string& query, int limit)
+{
+    if (userName.empty())
+    {
+        throw std::invalid_argument("User name cannot be empty.");
+    }
+
+    //Every query word becomes a quoted prefix term, so typeahead input never reaches FTS5 as raw syntax
+    std::string terms;
+    std::string phrase;
+    std::string word;
+    for (size_t i = 0; i <= query.size(); ++i)
+    {
+        unsigned char c = i < query.size() ? static_cast<unsigned char>(query[i]) : ' ';
+        if (std::isalnum(c) || c >= 0x80)
+        {
+            word.push_back(static_cast<char>(std::tolower(c)));
+        }
+        else if (!word.empty())
+        {
+            terms += (terms.empty() ? "\"" : " \"") + word + "\"*";
+            phrase += (phrase.empty() ? "" : " ") + word;
+            word.clear();
+        }
+    }
+
+    if (terms.empty() || limit <= 0)
+    {
+        return {};
+    }
+
+    std::string quotedUser;
+    bool userHasToken = false;
+    for (char c : userName)
+    {
+        quotedUser += c == '"' ? "\"\"" : std::string(1, c);
+        userHasToken = userHasToken || std::isalnum(static_cast<unsigned char>(c));
+    }
+
+    //Ranking tiers: file name starts with the query, file name contains every word, then content only.
+    //Each tier is its own match so old content matches on a large account cannot crowd out a new file name.
+    //bm25 would need corpus wide phrase statistics on every call, which costs more than the whole 5 ms
+    //typeahead budget on large accounts, so each tier is simply newest first.
+    //The user phrase only narrows the match, the join below is what enforces ownership. A name like "___" or one
+    //made only of emoji gives the tokenizer nothing to index, and an empty phrase would match no rows at all.
+    std::string userFilter = userHasToken ? "userName : \"" + quotedUser + "\" AND " : "";
+    std::string namePrefix = "fileName : ^ \"" + phrase + "\"*";
+    std::string nameWords = "fileName : (" + terms + ")";
+    const std::string tiers[] = {
+        userFilter + namePrefix,
+        userFilter + "(" + nameWords + " NOT " + namePrefix + ")",
+        userFilter + "({fileName content} : (" + terms + ") NOT " + nameWords + ")"
+    };
+
+    std::lock_guard<std::mutex> lock(searchMutex);
+
+    if (!searchDb)
+    {
+        searchDb = openDatabase(databasePath);
+
+        //Every save gets a fresh rowid, so FTS5 walks its index backwards and stops once a tier has enough rows
+        //instead of ranking every match. The join re-checks userName, dropping tokenizer collisions like "bob" vs "bob.smith".
+        const char* searchSQL = R"(
+            SELECT d.fileName FROM svg_search AS s
+            JOIN svg_data AS d ON d.rowid = s.rowid
+            WHERE svg_search MATCH ?1 AND d.userName = ?2
+            ORDER BY s.rowid DESC
+            LIMIT ?3;
+        )";
+
+        if (sqlite3_prepare_v3(searchDb, searchSQL, -1, SQLITE_PREPARE_PERSISTENT, &searchStmt, nullptr) != SQLITE_OK)
+        {
+            std::string error = sqlite3_errmsg(searchDb);
+            sqlite3_close(searchDb);
+            searchDb = nullptr;
+            throw std::runtime_error("Error preparing statement: " + error);
+        }
+    }
+
+    std::vector<std::string> fileList;
+    for (const std::string& matchExpression : tiers)
+    {
+        if (fileList.size() >= static_cast<size_t>(limit))
+        {
+            break;
+        }
+
+        sqlite3_bind_text(searchStmt, 1, matchExpression.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(searchStmt, 2, userName.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(searchStmt, 3, limit - static_cast<int>(fileList.size()));
+
+        int stepResult = SQLITE_DONE;
+        while ((stepResult = sqlite3_step(searchStmt)) == SQLITE_ROW)
+        {
+            fileList.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(searchStmt, 0)));
+        }
+
+        std::string error = stepResult == SQLITE_DONE ? "" : sqlite3_errmsg(searchDb);
+        sqlite3_reset(searchStmt);
+        sqlite3_clear_bindings(searchStmt);
+
+        if (stepResult != SQLITE_DONE)
+        {
+            throw std::runtime_error("Error searching documents: " + error);
+        }
+    }
+
     return fileList;
 }
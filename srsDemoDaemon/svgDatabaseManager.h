@@ -1,22 +1,47 @@
 #ifndef SVGDATABASEMANAGER_H
 #define SVGDATABASEMANAGER_H
 
+#include <functional>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
+struct sqlite3;
+struct sqlite3_stmt;
+
 class SVGDatabaseManager
 {
 public:
-    SVGDatabaseManager();
+    explicit SVGDatabaseManager(const std::string& databasePath);
     ~SVGDatabaseManager();
 
     void saveSVG(const std::string& fileName, const std::string& userName, const std::vector<unsigned char>& svgData);
     std::vector<unsigned char> getSVG(const std::string& fileName, const std::string& userName);
     std::vector<std::string> getFileList(const std::string& userName);
 
+    //Streams documents ordered by fileName, starting after afterFileName (empty for the first page).
+    //Stops once onRow returns false or limit rows have been visited. Returns the number of rows visited.
+    size_t exportSVGs(const std::string& userName, const std::string& afterFileName, size_t limit,
+        const std::function<bool(const std::string& fileName, const unsigned char* data, size_t size)>& onRow);
+
+    //Inserts or replaces all files in a single transaction
+    void importSVGs(const std::string& userName, const std::vector<std::pair<std::string, std::vector<unsigned char>>>& files);
+
+    //Prefix search over file names and document contents, file name matches first
+    std::vector<std::string> searchFiles(const std::string& userName, const std::string& query, int limit);
+
 private:
     std::string databasePath;
+
+    //Typeahead runs far more often than anything else, so it keeps its connection and page cache warm
+    sqlite3* searchDb = nullptr;
+    sqlite3_stmt* searchStmt = nullptr;
+    std::mutex searchMutex;
+
     void initializeDatabase();
+    void backfillSearchIndex(sqlite3* db);
+    static std::string extractSearchText(const unsigned char* svgData, size_t size);
 };
 
 #endif // SVGDATABASEMANAGER_H
@@ -0,0 +1,212 @@
+#include "trafficTrace.h"
+#include <nlohmann/json.hpp>
+#include <cstring>
+#include <stdexcept>
+
+using json = nlohmann::json;
+
+namespace
+{
+    constexpr char traceMagic[4] = { 'S', 'R', 'S', 'T' };
+    constexpr uint32_t traceVersion = 1;
+    constexpr uint64_t maxFrameSize = 256 * 1024 * 1024;
+
+    void appendVarint(std::string& out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+}
+
+TraceWriter::TraceWriter(const std::string& tracePath)
+    : out(tracePath, std::ios::binary | std::ios::trunc)
+{
+    if (!out.is_open())
+    {
+        throw std::runtime_error("Unable to open trace file " + tracePath);
+    }
+
+    char header[8] = { traceMagic[0], traceMagic[1], traceMagic[2], traceMagic[3],
+        static_cast<char>(traceVersion & 0xFF), static_cast<char>((traceVersion >> 8) & 0xFF),
+        static_cast<char>((traceVersion >> 16) & 0xFF), static_cast<char>((traceVersion >> 24) & 0xFF) };
+    out.write(header, sizeof(header));
+    out.flush();
+}
+
+void TraceWriter::write(const TraceRecord& record)
+{
+    std::string encoded;
+    encoded.reserve(16 + record.data.size());
+
+    encoded.push_back(static_cast<char>(record.type));
+    appendVarint(encoded, record.timestampMicros - lastTimestamp);
+    appendVarint(encoded, record.connectionID);
+
+    if (record.type == TraceRecordType::Frame || record.type == TraceRecordType::SessionIssued)
+    {
+        encoded.push_back(static_cast<char>(record.opCode));
+        appendVarint(encoded, record.data.size());
+        encoded.append(record.data);
+    }
+
+    lastTimestamp = record.timestampMicros;
+
+    //Flushed per record, the daemon is usually stopped with Ctrl+C and must not lose the tail of the trace
+    out.write(encoded.data(), encoded.size());
+    out.flush();
+}
+
+TraceReader::TraceReader(const std::string& tracePath)
+    : in(tracePath, std::ios::binary)
+{
+    if (!in.is_open())
+    {
+        throw std::runtime_error("Unable to open trace file " + tracePath);
+    }
+
+    char header[8] = {};
+    if (!in.read(header, sizeof(header)) || std::memcmp(header, traceMagic, sizeof(traceMagic)) != 0)
+    {
+        throw std::runtime_error("Not an SRS trace file: " + tracePath);
+    }
+
+    const unsigned char* version = reinterpret_cast<const unsigned char*>(header + sizeof(traceMagic));
+    if ((uint32_t(version[0]) | (uint32_t(version[1]) << 8) | (uint32_t(version[2]) << 16) | (uint32_t(version[3]) << 24)) != traceVersion)
+    {
+        throw std::runtime_error("Unsupported trace version in " + tracePath);
+    }
+}
+
+bool TraceReader::readVarint(uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        int byte = in.get();
+        if (byte == std::char_traits<char>::eof())
+        {
+            return false;
+        }
+
+        value |= uint64_t(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+
+    throw std::runtime_error("Corrupt varint in trace.");
+}
+
+bool TraceReader::next(TraceRecord& record)
+{
+    int type = in.get();
+    if (type == std::char_traits<char>::eof())
+    {
+        return false;
+    }
+
+    if (type < static_cast<int>(TraceRecordType::Open) || type > static_cast<int>(TraceRecordType::SessionIssued))
+    {
+        throw std::runtime_error("Unknown record type in trace.");
+    }
+
+    uint64_t delta = 0;
+    if (!readVarint(delta) || !readVarint(record.connectionID))
+    {
+        throw std::runtime_error("Truncated record in trace.");
+    }
+
+    record.type = static_cast<TraceRecordType>(type);
+    lastTimestamp += delta;
+    record.timestampMicros = lastTimestamp;
+    record.opCode = 0;
+    record.data.clear();
+
+    if (record.type == TraceRecordType::Frame || record.type == TraceRecordType::SessionIssued)
+    {
+        int opCode = in.get();
+        uint64_t size = 0;
+        if (opCode == std::char_traits<char>::eof() || !readVarint(size) || size > maxFrameSize)
+        {
+            throw std::runtime_error("Truncated record in trace.");
+        }
+
+        record.opCode = static_cast<uint8_t>(opCode);
+        record.data.resize(size);
+        if (size > 0 && !in.read(record.data.data(), static_cast<std::streamsize>(size)))
+        {
+            throw std::runtime_error("Truncated record in trace.");
+        }
+    }
+
+    return true;
+}
+
+TrafficCapture::TrafficCapture(const std::string& tracePath)
+    : writer(tracePath), start(std::chrono::steady_clock::now())
+{
+}
+
+uint64_t TrafficCapture::elapsedMicros() const
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+const std::string& TrafficCapture::sessionAlias(const std::string& sessionID)
+{
+    auto it = sessionAliases.find(sessionID);
+    if (it == sessionAliases.end())
+    {
+        it = sessionAliases.emplace(sessionID, "session-" + std::to_string(sessionAliases.size() + 1)).first;
+    }
+    return it->second;
+}
+
+std::string TrafficCapture::redact(std::string_view message)
+{
+    json payload = json::parse(message, nullptr, false);
+    if (payload.is_discarded() || !payload.is_object())
+    {
+        return std::string(message);
+    }
+
+    if (payload.contains("password"))
+    {
+        payload["password"] = redactedPassword;
+    }
+
+    if (payload.contains("sessionId") && payload["sessionId"].is_string())
+    {
+        payload["sessionId"] = sessionAlias(payload["sessionId"].get<std::string>());
+    }
+
+    return payload.dump();
+}
+
+void TrafficCapture::recordOpen(uint64_t connectionID)
+{
+    writer.write({ TraceRecordType::Open, elapsedMicros(), connectionID, 0, "" });
+}
+
+void TrafficCapture::recordClose(uint64_t connectionID)
+{
+    writer.write({ TraceRecordType::Close, elapsedMicros(), connectionID, 0, "" });
+}
+
+void TrafficCapture::recordFrame(uint64_t connectionID, uint8_t opCode, std::string_view message)
+{
+    //Binary frames are archive data for importAll and carry no credentials
+    constexpr uint8_t textOpCode = 1;
+    std::string data = opCode == textOpCode ? redact(message) : std::string(message);
+    writer.write({ TraceRecordType::Frame, elapsedMicros(), connectionID, opCode, std::move(data) });
+}
+
+void TrafficCapture::recordSessionIssued(uint64_t connectionID, const std::string& sessionID)
+{
+    writer.write({ TraceRecordType::SessionIssued, elapsedMicros(), connectionID, 0, sessionAlias(sessionID) });
+}
@@ -0,0 +1,84 @@
+#ifndef TRAFFICTRACE_H
+#define TRAFFICTRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+//Trace layout: "SRST" + u32 version, then records of
+//u8 type, varint microseconds since the previous record, varint connection ID,
+//and for frames u8 opcode + varint length + payload.
+enum class TraceRecordType : uint8_t
+{
+    Open = 1,
+    Close = 2,
+    Frame = 3,
+    SessionIssued = 4 //data holds the alias of a session the server just handed out on this connection
+};
+
+struct TraceRecord
+{
+    TraceRecordType type = TraceRecordType::Frame;
+    uint64_t timestampMicros = 0;
+    uint64_t connectionID = 0;
+    uint8_t opCode = 0;
+    std::string data;
+};
+
+//Placeholder written over every password. The replay tool substitutes its own.
+inline constexpr std::string_view redactedPassword = "<redacted>";
+
+class TraceWriter
+{
+public:
+    explicit TraceWriter(const std::string& tracePath);
+
+    void write(const TraceRecord& record);
+
+private:
+    std::ofstream out;
+    uint64_t lastTimestamp = 0;
+};
+
+class TraceReader
+{
+public:
+    explicit TraceReader(const std::string& tracePath);
+
+    //Returns false at the end of the trace. Throws on malformed input.
+    bool next(TraceRecord& record);
+
+private:
+    std::ifstream in;
+    uint64_t lastTimestamp = 0;
+
+    bool readVarint(uint64_t& value);
+};
+
+//Records incoming traffic with credentials redacted: passwords are replaced and every
+//session ID is swapped for a stable alias, so a replay can map them onto its own sessions.
+//Not thread safe, meant to be driven from the event loop thread.
+class TrafficCapture
+{
+public:
+    explicit TrafficCapture(const std::string& tracePath);
+
+    void recordOpen(uint64_t connectionID);
+    void recordClose(uint64_t connectionID);
+    void recordFrame(uint64_t connectionID, uint8_t opCode, std::string_view message);
+    void recordSessionIssued(uint64_t connectionID, const std::string& sessionID);
+
+private:
+    TraceWriter writer;
+    std::chrono::steady_clock::time_point start;
+    std::unordered_map<std::string, std::string> sessionAliases;
+
+    uint64_t elapsedMicros() const;
+    const std::string& sessionAlias(const std::string& sessionID);
+    std::string redact(std::string_view message);
+};
+
+#endif // TRAFFICTRACE_H
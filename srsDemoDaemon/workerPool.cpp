@@ -0,0 +1,61 @@
+#include "workerPool.h"
+
+WorkerPool::WorkerPool(size_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = 1;
+    }
+
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        stopping = true;
+    }
+    tasksCondition.notify_all();
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void WorkerPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(tasksMutex);
+        tasks.push(std::move(task));
+    }
+    tasksCondition.notify_one();
+}
+
+void WorkerPool::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(tasksMutex);
+            tasksCondition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+
+            //Queued work is dropped on shutdown, the event loop that would deliver its results is gone
+            if (stopping)
+            {
+                return;
+            }
+
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+
+        task();
+    }
+}
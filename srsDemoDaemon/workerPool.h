@@ -0,0 +1,34 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+//Fixed set of threads for work that must not stall the socket event loop
+class WorkerPool
+{
+public:
+    explicit WorkerPool(size_t threadCount);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void submit(std::function<void()> task);
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex tasksMutex;
+    std::condition_variable tasksCondition;
+    bool stopping = false;
+
+    void workerLoop();
+};
+
+#endif // WORKERPOOL_H